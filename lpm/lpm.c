@@ -9,9 +9,49 @@
 #include <sys/queue.h>
 #include <time.h>
 #include <arpa/inet.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "lpm.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+/* Alignment of the tables inside the LPM memory block. */
+#define LPM_CACHE_LINE_SIZE 64
+
+#define LPM_ALIGN_CEIL(val) \
+	(((size_t)(val) + LPM_CACHE_LINE_SIZE - 1) & \
+	 ~((size_t)LPM_CACHE_LINE_SIZE - 1))
+
+
+/*
+ * Points the writer side table pointers at the current mapping of the block.
+ */
+static void
+lpm_set_pointers(struct __rte_lpm *i_lpm)
+{
+	i_lpm->lpm.tbl8 = (struct rte_lpm_tbl_entry *)((uintptr_t)i_lpm +
+			i_lpm->lpm.tbl8_offset);
+	i_lpm->rules_tbl = (struct rte_lpm_rule *)((uintptr_t)i_lpm +
+			i_lpm->rules_offset);
+	i_lpm->tbl8_owner = (uint32_t *)((uintptr_t)i_lpm +
+			i_lpm->tbl8_owner_offset);
+
+	if (i_lpm->links_offset != 0) {
+		i_lpm->rule_links = (struct rte_lpm_rule_link *)
+			((uintptr_t)i_lpm + i_lpm->links_offset);
+		i_lpm->nh_heads = (uint32_t *)((uintptr_t)i_lpm +
+				i_lpm->nh_heads_offset);
+	}
+}
+
 
 static uint32_t depth_to_mask(uint8_t depth)
 {
@@ -33,70 +73,224 @@ static uint32_t depth_to_range(uint8_t depth)
 
 
 /*
- * Allocates memory for LPM object
+ * Layout of the single memory block holding an LPM object. Every table is
+ * placed at a fixed offset from the block base so that the block can be
+ * mapped at different addresses in different processes.
  */
-struct rte_lpm *
-rte_lpm_create(const char *name, const struct rte_lpm_config *config)
+struct lpm_mem_layout {
+	size_t tbl8_offset;
+	size_t rules_offset;
+	size_t nh_offset;
+	uint32_t nh_slot_shift;
+	size_t links_offset;
+	size_t nh_heads_offset;
+	size_t tbl8_owner_offset;
+	size_t mem_size;
+};
+
+static int
+lpm_mem_layout(const struct rte_lpm_config *config,
+		struct lpm_mem_layout *layout)
 {
-	char mem_name[RTE_LPM_NAMESIZE];
-	struct __rte_lpm *i_lpm;
-	struct rte_lpm *lpm = NULL;
-	uint32_t mem_size, rules_size, tbl8s_size;
-	struct rte_lpm_list *lpm_list;
+	size_t rules_size, tbl8s_size, nh_size = 0, links_size = 0;
+	size_t nh_heads_size = 0;
 
 	/* Check user arguments. */
-	if ((name == NULL) || (config->max_rules == 0)
-			|| config->number_tbl8s > RTE_LPM_MAX_TBL8_NUM_GROUPS) {
-		errno = EINVAL;
-		return NULL;
+	if ((config == NULL) || (config->max_rules == 0)
+			|| config->number_tbl8s > RTE_LPM_MAX_TBL8_NUM_GROUPS)
+		return -EINVAL;
+
+	layout->nh_slot_shift = 0;
+	if (config->flags & (RTE_LPM_F_NH_INDIRECT | RTE_LPM_F_ECMP)) {
+		/* Ids are stored in the 24 bit next_hop field. */
+		if ((config->number_nh == 0) ||
+				(config->number_nh > RTE_LPM_MAX_NH))
+			return -EINVAL;
+		if (config->flags & RTE_LPM_F_ECMP)
+			layout->nh_slot_shift = RTE_LPM_ECMP_SLOTS_LOG2;
+		nh_size = (sizeof(uint32_t) * config->number_nh) <<
+				layout->nh_slot_shift;
 	}
 
-	snprintf(mem_name, sizeof(mem_name), "LPM_%s", name);
+	if (config->flags & RTE_LPM_F_NH_INDEX) {
+		if ((config->number_nh == 0) ||
+				(config->number_nh > RTE_LPM_MAX_NH))
+			return -EINVAL;
+		links_size = sizeof(struct rte_lpm_rule_link) *
+				config->max_rules;
+		nh_heads_size = sizeof(uint32_t) * config->number_nh;
+	}
 
-	/* Determine the amount of memory to allocate. */
-	mem_size = sizeof(*i_lpm);
 	rules_size = sizeof(struct rte_lpm_rule) * config->max_rules;
 	tbl8s_size = sizeof(struct rte_lpm_tbl_entry) *
 			RTE_LPM_TBL8_GROUP_NUM_ENTRIES * config->number_tbl8s;
 
+	layout->tbl8_offset = LPM_ALIGN_CEIL(sizeof(struct __rte_lpm));
+	layout->rules_offset = LPM_ALIGN_CEIL(layout->tbl8_offset +
+			tbl8s_size);
+	layout->nh_offset = LPM_ALIGN_CEIL(layout->rules_offset + rules_size);
+	layout->links_offset = LPM_ALIGN_CEIL(layout->nh_offset + nh_size);
+	layout->nh_heads_offset = LPM_ALIGN_CEIL(layout->links_offset +
+			links_size);
+	layout->tbl8_owner_offset = LPM_ALIGN_CEIL(layout->nh_heads_offset +
+			nh_heads_size);
+	layout->mem_size = LPM_ALIGN_CEIL(layout->tbl8_owner_offset +
+			sizeof(uint32_t) * config->number_tbl8s);
+	if (nh_size == 0)
+		layout->nh_offset = 0;
+	if (links_size == 0)
+		layout->links_offset = layout->nh_heads_offset = 0;
+
+	return 0;
+}
+
+
+/*
+ * Initialises an LPM object in a zeroed block laid out by lpm_mem_layout().
+ */
+static struct rte_lpm *
+lpm_init(void *mem, const char *name, const struct rte_lpm_config *config,
+		const struct lpm_mem_layout *layout)
+{
+	struct __rte_lpm *i_lpm = mem;
+
+	/* Save user arguments. */
+	i_lpm->max_rules = config->max_rules;
+	i_lpm->number_tbl8s = config->number_tbl8s;
+	strncpy(i_lpm->name, name, sizeof(i_lpm->name) - 1);
+
+	if (layout->nh_offset != 0 || layout->links_offset != 0)
+		i_lpm->number_nh = config->number_nh;
+
+	i_lpm->lpm.tbl8_offset = layout->tbl8_offset;
+	i_lpm->lpm.nh_offset = layout->nh_offset;
+	i_lpm->lpm.nh_slot_shift = layout->nh_slot_shift;
+	i_lpm->rules_offset = layout->rules_offset;
+	i_lpm->links_offset = layout->links_offset;
+	i_lpm->nh_heads_offset = layout->nh_heads_offset;
+	i_lpm->tbl8_owner_offset = layout->tbl8_owner_offset;
+	i_lpm->mem_size = layout->mem_size;
+	lpm_set_pointers(i_lpm);
+
+	/* Publish the object only once everything above is visible. */
+	__atomic_store_n(&i_lpm->magic, RTE_LPM_MAGIC, __ATOMIC_RELEASE);
+
+	return &i_lpm->lpm;
+}
+
+
+/*
+ * Allocates memory for LPM object
+ */
+struct rte_lpm *
+rte_lpm_create(const char *name, const struct rte_lpm_config *config)
+{
+	struct lpm_mem_layout layout;
+	void *mem;
+
+	/* Check user arguments. */
+	if ((name == NULL) || lpm_mem_layout(config, &layout) < 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+
 	/* Allocate memory to store the LPM data structures. */
-	i_lpm = malloc(mem_size);
-	if (i_lpm == NULL) {
+	mem = calloc(1, layout.mem_size);
+	if (mem == NULL) {
 		printf("LPM memory allocation failed\n");
 		errno = ENOMEM;
-		goto exit;
+		return NULL;
 	}
 
-	i_lpm->rules_tbl = malloc((size_t)rules_size);
+	return lpm_init(mem, name, config, &layout);
+}
 
-	if (i_lpm->rules_tbl == NULL) {
-		printf("LPM rules_tbl memory allocation failed\n");
-		free(i_lpm);
-		i_lpm = NULL;
-		errno = ENOMEM;
-		goto exit;
-	}
 
-	i_lpm->lpm.tbl8 = malloc((size_t)tbl8s_size);
+/*
+ * Frees an LPM object, detaching it if it lives in shared memory.
+ */
+void
+rte_lpm_free(struct rte_lpm *lpm)
+{
+	struct __rte_lpm *i_lpm;
+
+	if (lpm == NULL)
+		return;
 
-	if (i_lpm->lpm.tbl8 == NULL) {
-		printf("LPM tbl8 memory allocation failed\n");
-		free(i_lpm->rules_tbl);
-		free(i_lpm);
-		i_lpm = NULL;
-		errno = ENOMEM;
-		goto exit;
+	i_lpm = container_of(lpm, struct __rte_lpm, lpm);
+	if (i_lpm->shm) {
+		rte_lpm_shm_detach(lpm);
+		return;
 	}
 
-	/* Save user arguments. */
-	i_lpm->max_rules = config->max_rules;
-	i_lpm->number_tbl8s = config->number_tbl8s;
-	strncpy(i_lpm->name, name, sizeof(i_lpm->name));
+	free(i_lpm);
+}
 
-	lpm = &i_lpm->lpm;
 
-exit:
-	return lpm;
+/*
+ * Links rule_index at the head of the rule list of its next hop.
+ */
+static void
+rule_link(struct __rte_lpm *i_lpm, uint32_t rule_index)
+{
+	struct rte_lpm_rule_link *links = i_lpm->rule_links;
+	uint32_t *head;
+
+	if (links == NULL)
+		return;
+
+	head = &i_lpm->nh_heads[i_lpm->rules_tbl[rule_index].next_hop];
+	links[rule_index].prev = 0;
+	links[rule_index].next = *head;
+	if (*head != 0)
+		links[*head - 1].prev = rule_index + 1;
+	*head = rule_index + 1;
+}
+
+
+static void
+rule_unlink(struct __rte_lpm *i_lpm, uint32_t rule_index)
+{
+	struct rte_lpm_rule_link *links = i_lpm->rule_links;
+	struct rte_lpm_rule_link *link;
+
+	if (links == NULL)
+		return;
+
+	link = &links[rule_index];
+	if (link->prev != 0)
+		links[link->prev - 1].next = link->next;
+	else
+		i_lpm->nh_heads[i_lpm->rules_tbl[rule_index].next_hop] =
+				link->next;
+	if (link->next != 0)
+		links[link->next - 1].prev = link->prev;
+}
+
+
+/*
+ * Moves a rule to a free slot of the rule table, keeping its next hop list
+ * pointing at it.
+ */
+static void
+rule_move(struct __rte_lpm *i_lpm, uint32_t dst, uint32_t src)
+{
+	struct rte_lpm_rule_link *links = i_lpm->rule_links;
+
+	if (dst == src)
+		return;
+
+	i_lpm->rules_tbl[dst] = i_lpm->rules_tbl[src];
+	if (links == NULL)
+		return;
+
+	links[dst] = links[src];
+	if (links[dst].prev != 0)
+		links[links[dst].prev - 1].next = dst + 1;
+	else
+		i_lpm->nh_heads[i_lpm->rules_tbl[dst].next_hop] = dst + 1;
+	if (links[dst].next != 0)
+		links[links[dst].next - 1].prev = dst + 1;
 }
 
 
@@ -137,7 +331,9 @@ rule_add(struct __rte_lpm *i_lpm, uint32_t ip_masked, uint8_t depth,
 				if (i_lpm->rules_tbl[rule_index].next_hop
 						== next_hop)
 					return -EEXIST;
+				rule_unlink(i_lpm, rule_index);
 				i_lpm->rules_tbl[rule_index].next_hop = next_hop;
+				rule_link(i_lpm, rule_index);
 
 				return rule_index;
 			}
@@ -169,9 +365,9 @@ rule_add(struct __rte_lpm *i_lpm, uint32_t ip_masked, uint8_t depth,
 			return -ENOSPC;
 
 		if (i_lpm->rule_info[i - 1].used_rules > 0) {
-			i_lpm->rules_tbl[i_lpm->rule_info[i - 1].first_rule
-				+ i_lpm->rule_info[i - 1].used_rules]
-					= i_lpm->rules_tbl[i_lpm->rule_info[i - 1].first_rule];
+			rule_move(i_lpm, i_lpm->rule_info[i - 1].first_rule
+				+ i_lpm->rule_info[i - 1].used_rules,
+				i_lpm->rule_info[i - 1].first_rule);
 			i_lpm->rule_info[i - 1].first_rule++;
 		}
 	}
@@ -179,6 +375,7 @@ rule_add(struct __rte_lpm *i_lpm, uint32_t ip_masked, uint8_t depth,
 	/* Add the new rule. */
 	i_lpm->rules_tbl[rule_index].ip = ip_masked;
 	i_lpm->rules_tbl[rule_index].next_hop = next_hop;
+	rule_link(i_lpm, rule_index);
 
 	/* Increment the used rules counter for this rule group. */
 	i_lpm->rule_info[depth - 1].used_rules++;
@@ -297,12 +494,16 @@ _tbl8_alloc(struct __rte_lpm *i_lpm)
 }
 
 static int32_t
-tbl8_alloc(struct __rte_lpm *i_lpm)
+tbl8_alloc(struct __rte_lpm *i_lpm, uint32_t tbl24_index)
 {
 	int32_t group_idx; /* tbl8 group index. */
 
 	group_idx = _tbl8_alloc(i_lpm);
 
+	/* Remember the owner so the group can be relocated. */
+	if (group_idx >= 0)
+		i_lpm->tbl8_owner[group_idx] = tbl24_index;
+
 	return group_idx;
 }
 
@@ -321,7 +522,7 @@ add_depth_big(struct __rte_lpm *i_lpm, uint32_t ip_masked, uint8_t depth,
 
 	if (!i_lpm->lpm.tbl24[tbl24_index].valid) {
 		/* Search for a free tbl8 group. */
-		tbl8_group_index = tbl8_alloc(i_lpm);
+		tbl8_group_index = tbl8_alloc(i_lpm, tbl24_index);
 
 		/* Check tbl8 allocation was successful. */
 		if (tbl8_group_index < 0) {
@@ -367,7 +568,7 @@ add_depth_big(struct __rte_lpm *i_lpm, uint32_t ip_masked, uint8_t depth,
 	} /* If valid entry but not extended calculate the index into Table8. */
 	else if (i_lpm->lpm.tbl24[tbl24_index].valid_group == 0) {
 		/* Search for free tbl8 group. */
-		tbl8_group_index = tbl8_alloc(i_lpm);
+		tbl8_group_index = tbl8_alloc(i_lpm, tbl24_index);
 
 		if (tbl8_group_index < 0) {
 			return tbl8_group_index;
@@ -469,15 +670,16 @@ rule_delete(struct __rte_lpm *i_lpm, int32_t rule_index, uint8_t depth)
 
 	VERIFY_DEPTH(depth);
 
-	i_lpm->rules_tbl[rule_index] =
-			i_lpm->rules_tbl[i_lpm->rule_info[depth - 1].first_rule
-			+ i_lpm->rule_info[depth - 1].used_rules - 1];
+	rule_unlink(i_lpm, rule_index);
+	rule_move(i_lpm, rule_index,
+			i_lpm->rule_info[depth - 1].first_rule
+			+ i_lpm->rule_info[depth - 1].used_rules - 1);
 
 	for (i = depth; i < RTE_LPM_MAX_DEPTH; i++) {
 		if (i_lpm->rule_info[i].used_rules > 0) {
-			i_lpm->rules_tbl[i_lpm->rule_info[i].first_rule - 1] =
-					i_lpm->rules_tbl[i_lpm->rule_info[i].first_rule
-						+ i_lpm->rule_info[i].used_rules - 1];
+			rule_move(i_lpm, i_lpm->rule_info[i].first_rule - 1,
+					i_lpm->rule_info[i].first_rule
+						+ i_lpm->rule_info[i].used_rules - 1);
 			i_lpm->rule_info[i].first_rule--;
 		}
 	}
@@ -503,6 +705,13 @@ int rte_lpm_add(struct rte_lpm *lpm, uint32_t ip, uint8_t depth,
 	i_lpm = container_of(lpm, struct __rte_lpm, lpm);
 	ip_masked = ip & depth_to_mask(depth);
 
+	/*
+	 * In indirect mode the next hop is a next-hop table index, with a
+	 * next hop index it selects one of the next hop lists.
+	 */
+	if ((i_lpm->number_nh != 0) && (next_hop >= i_lpm->number_nh))
+		return -EINVAL;
+
 	/* Add the rule to the rule table. */
 	rule_index = rule_add(i_lpm, ip_masked, depth, next_hop);
 
@@ -594,15 +803,429 @@ int rte_lpm_lookup(struct rte_lpm *lpm, uint32_t ip, uint32_t *next_hop)
 				(((uint32_t)tbl_entry & 0x00FFFFFF) *
 						RTE_LPM_TBL8_GROUP_NUM_ENTRIES);
 
-		ptbl = (const uint32_t *)&lpm->tbl8[tbl8_index];
+		ptbl = (const uint32_t *)&rte_lpm_tbl8(lpm)[tbl8_index];
 		tbl_entry = *ptbl;
 	}
 
 	*next_hop = ((uint32_t)tbl_entry & 0x00FFFFFF);
+
+	/* Resolve the next-hop id in indirect mode. */
+	if (lpm->nh_offset != 0 && (tbl_entry & RTE_LPM_LOOKUP_SUCCESS))
+		*next_hop = __atomic_load_n(&rte_lpm_nh_tbl(lpm)
+				[*next_hop << lpm->nh_slot_shift],
+				__ATOMIC_RELAXED);
+
 	return (tbl_entry & RTE_LPM_LOOKUP_SUCCESS) ? 0 : -ENOENT;
 }
 
 
+/*
+ * tbl24/tbl8 entry of one IP, masked to the next hop (or next-hop id) and
+ * the RTE_LPM_LOOKUP_SUCCESS bit.
+ */
+static inline uint32_t
+lpm_lookup_entry(const struct rte_lpm *lpm,
+		const struct rte_lpm_tbl_entry *tbl8, uint32_t ip)
+{
+	const uint32_t *ptbl;
+	uint32_t tbl_entry;
+
+	ptbl = (const uint32_t *)&lpm->tbl24[ip >> 8];
+	tbl_entry = *ptbl;
+
+	if ((tbl_entry & RTE_LPM_VALID_EXT_ENTRY_BITMASK) ==
+			RTE_LPM_VALID_EXT_ENTRY_BITMASK) {
+		unsigned tbl8_index = (uint8_t)ip +
+				((tbl_entry & 0x00FFFFFF) *
+				 RTE_LPM_TBL8_GROUP_NUM_ENTRIES);
+
+		ptbl = (const uint32_t *)&tbl8[tbl8_index];
+		tbl_entry = *ptbl;
+	}
+
+	return tbl_entry & 0x01FFFFFF;
+}
+
+
+#if defined(__AVX2__)
+/*
+ * Largest tbl8 pool whose entry indexes fit the signed 32 bit indexes of
+ * a gather.
+ */
+#define LPM_GATHER_MAX_TBL8_GROUPS \
+	(INT32_MAX / RTE_LPM_TBL8_GROUP_NUM_ENTRIES)
+
+/*
+ * lpm_lookup_entry() for 8 IPs held in host byte order in a register.
+ */
+static inline void
+lpm_lookup_entry_x8(const struct rte_lpm *lpm,
+		const struct rte_lpm_tbl_entry *tbl8, __m256i ip,
+		uint32_t *next_hops)
+{
+	const __m256i ext_mask = _mm256_set1_epi32(
+			RTE_LPM_VALID_EXT_ENTRY_BITMASK);
+	const __m256i id_mask = _mm256_set1_epi32(0x00FFFFFF);
+	const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+	__m256i entry, ext, idx;
+
+	entry = _mm256_i32gather_epi32((const int *)lpm->tbl24,
+			_mm256_srli_epi32(ip, 8), 4);
+
+	/* Only extended entries gather their tbl8 entry. */
+	ext = _mm256_cmpeq_epi32(_mm256_and_si256(entry, ext_mask), ext_mask);
+	idx = _mm256_add_epi32(
+		_mm256_slli_epi32(_mm256_and_si256(entry, id_mask), 8),
+		_mm256_and_si256(ip, byte_mask));
+	entry = _mm256_mask_i32gather_epi32(entry, (const int *)tbl8, idx,
+			ext, 4);
+
+	_mm256_storeu_si256((__m256i *)next_hops, _mm256_and_si256(entry,
+			_mm256_set1_epi32(0x01FFFFFF)));
+}
+
+
+/* Byte swap of every 32 bit lane, network to host order. */
+static inline __m256i
+lpm_bswap32_x8(__m256i v)
+{
+	const __m256i shuf = _mm256_set_epi8(
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+	return _mm256_shuffle_epi8(v, shuf);
+}
+
+
+static inline int
+lpm_gather_ok(const struct rte_lpm *lpm)
+{
+	const struct __rte_lpm *i_lpm =
+		container_of(lpm, const struct __rte_lpm, lpm);
+
+	return i_lpm->number_tbl8s <= LPM_GATHER_MAX_TBL8_GROUPS;
+}
+#endif
+
+
+/*
+ * First level of a bulk lookup: lpm_lookup_entry() of every IP.
+ */
+static inline void
+lpm_lookup_bulk_entries(const struct rte_lpm *lpm, const uint32_t *ips,
+		uint32_t *next_hops, unsigned int n)
+{
+	const struct rte_lpm_tbl_entry *tbl8 = rte_lpm_tbl8(lpm);
+	unsigned int i = 0;
+
+#if defined(__AVX2__)
+	if (lpm_gather_ok(lpm))
+		for (; i + 8 <= n; i += 8)
+			lpm_lookup_entry_x8(lpm, tbl8, _mm256_loadu_si256(
+				(const __m256i *)&ips[i]), &next_hops[i]);
+#endif
+
+	for (; i < n; i++)
+		next_hops[i] = lpm_lookup_entry(lpm, tbl8, ips[i]);
+}
+
+
+/*
+ * Second level of a bulk lookup in indirect mode: replaces every hit with
+ * slot (hash & slot mask) of its next-hop id. A single path id has the
+ * same next hop in all of its slots, so it takes exactly the same path as
+ * an ECMP group. Without hashes slot 0 is used.
+ */
+static inline void
+lpm_lookup_bulk_resolve(const struct rte_lpm *lpm, const uint32_t *hashes,
+		uint32_t *next_hops, unsigned int n)
+{
+	const uint32_t *nh_tbl = rte_lpm_nh_tbl(lpm);
+	const uint32_t shift = lpm->nh_slot_shift;
+	const uint32_t slot_mask = hashes != NULL ? (1U << shift) - 1 : 0;
+	unsigned int i = 0;
+	uint32_t slot;
+
+#if defined(__AVX2__)
+	const __m256i success = _mm256_set1_epi32(RTE_LPM_LOOKUP_SUCCESS);
+	const __m256i id_mask = _mm256_set1_epi32(0x00FFFFFF);
+	const __m256i vslot_mask = _mm256_set1_epi32(slot_mask);
+	const __m128i vshift = _mm_cvtsi32_si128(shift);
+
+	for (; i + 8 <= n; i += 8) {
+		__m256i entry, hit, idx, nh, hash;
+
+		entry = _mm256_loadu_si256((const __m256i *)&next_hops[i]);
+		hash = hashes != NULL ?
+			_mm256_loadu_si256((const __m256i *)&hashes[i]) :
+			_mm256_setzero_si256();
+
+		hit = _mm256_cmpeq_epi32(_mm256_and_si256(entry, success),
+				success);
+		idx = _mm256_or_si256(
+			_mm256_sll_epi32(_mm256_and_si256(entry, id_mask), vshift),
+			_mm256_and_si256(hash, vslot_mask));
+
+		/* Misses are not gathered and keep their entry. */
+		nh = _mm256_mask_i32gather_epi32(entry, (const int *)nh_tbl,
+				idx, hit, 4);
+		nh = _mm256_or_si256(nh, _mm256_and_si256(hit, success));
+
+		_mm256_storeu_si256((__m256i *)&next_hops[i], nh);
+	}
+#endif
+
+	for (; i < n; i++) {
+		if (!(next_hops[i] & RTE_LPM_LOOKUP_SUCCESS))
+			continue;
+
+		slot = hashes != NULL ? (hashes[i] & slot_mask) : 0;
+		next_hops[i] = RTE_LPM_LOOKUP_SUCCESS | __atomic_load_n(
+			&nh_tbl[((next_hops[i] & 0x00FFFFFF) << shift) | slot],
+			__ATOMIC_RELAXED);
+	}
+}
+
+
+/**
+ * Lookup multiple IP addresses in an LPM table.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @param ips
+ *   Array of IPs to be looked up in the LPM table
+ * @param next_hops
+ *   Next hop of the most specific rule found for IP. This is an array of
+ *   uint32_t values; the next hop is stored in the low 24 bits and
+ *   RTE_LPM_LOOKUP_SUCCESS is set on a lookup hit. In indirect mode the
+ *   next-hop id is already resolved through the next-hop table.
+ * @param n
+ *   Number of elements in ips (and next_hops) array to lookup
+ * @return
+ *   -EINVAL for incorrect arguments, otherwise 0
+ */
+int rte_lpm_lookup_bulk(struct rte_lpm *lpm, const uint32_t *ips,
+		uint32_t *next_hops, unsigned int n)
+{
+	if ((lpm == NULL) || (ips == NULL) || (next_hops == NULL))
+		return -EINVAL;
+
+	lpm_lookup_bulk_entries(lpm, ips, next_hops, n);
+	if (lpm->nh_offset != 0)
+		lpm_lookup_bulk_resolve(lpm, NULL, next_hops, n);
+
+	return 0;
+}
+
+
+/**
+ * Lookup multiple IP addresses and select an ECMP member per packet.
+ *
+ * Same as rte_lpm_lookup_bulk(), except that in RTE_LPM_F_ECMP mode the
+ * member of the matching group is chosen from the packet flow hash, so
+ * packets of one flow always use the same member. Single path routes go
+ * through the same selection with no extra branch.
+ *
+ * @param hashes
+ *   Flow hash of every packet
+ * @return
+ *   -EINVAL for incorrect arguments, otherwise 0
+ */
+int rte_lpm_lookup_bulk_hash(struct rte_lpm *lpm, const uint32_t *ips,
+		const uint32_t *hashes, uint32_t *next_hops, unsigned int n)
+{
+	if ((lpm == NULL) || (ips == NULL) || (hashes == NULL) ||
+			(next_hops == NULL))
+		return -EINVAL;
+
+	lpm_lookup_bulk_entries(lpm, ips, next_hops, n);
+	if (lpm->nh_offset != 0)
+		lpm_lookup_bulk_resolve(lpm, hashes, next_hops, n);
+
+	return 0;
+}
+
+
+/**
+ * Lookup the destination of multiple IPv4 headers in an LPM table.
+ *
+ * The destination addresses are loaded straight from the headers and
+ * converted to host byte order in registers, so callers need neither a
+ * conversion loop nor a temporary array of addresses.
+ *
+ * @param hdrs
+ *   Array of pointers to IPv4 headers
+ * @param next_hops
+ *   Same as for rte_lpm_lookup_bulk()
+ * @return
+ *   -EINVAL for incorrect arguments, otherwise 0
+ */
+int rte_lpm_lookup_bulk_ipv4(struct rte_lpm *lpm,
+		const struct iphdr *const *hdrs, uint32_t *next_hops,
+		unsigned int n)
+{
+	const struct rte_lpm_tbl_entry *tbl8;
+	unsigned int i = 0;
+
+	if ((lpm == NULL) || (hdrs == NULL) || (next_hops == NULL))
+		return -EINVAL;
+
+	tbl8 = rte_lpm_tbl8(lpm);
+
+#if defined(__AVX2__)
+	if (lpm_gather_ok(lpm)) {
+		const __m256i daddr_off = _mm256_set1_epi64x(
+				offsetof(struct iphdr, daddr));
+		__m128i lo, hi;
+
+		for (; i + 8 <= n; i += 8) {
+			/* Gather the daddr fields through the header pointers. */
+			lo = _mm256_i64gather_epi32(NULL, _mm256_add_epi64(
+				_mm256_loadu_si256((const __m256i *)&hdrs[i]),
+				daddr_off), 1);
+			hi = _mm256_i64gather_epi32(NULL, _mm256_add_epi64(
+				_mm256_loadu_si256((const __m256i *)&hdrs[i + 4]),
+				daddr_off), 1);
+
+			lpm_lookup_entry_x8(lpm, tbl8, lpm_bswap32_x8(
+				_mm256_set_m128i(hi, lo)), &next_hops[i]);
+		}
+	}
+#endif
+
+	for (; i < n; i++)
+		next_hops[i] = lpm_lookup_entry(lpm, tbl8,
+				ntohl(hdrs[i]->daddr));
+
+	if (lpm->nh_offset != 0)
+		lpm_lookup_bulk_resolve(lpm, NULL, next_hops, n);
+
+	return 0;
+}
+
+
+/**
+ * Lookup the destination of n IPv4 headers laid out every stride bytes
+ * from base, for instance in an array of packet buffers.
+ *
+ * @return
+ *   -EINVAL for incorrect arguments, otherwise 0
+ */
+int rte_lpm_lookup_bulk_ipv4_stride(struct rte_lpm *lpm, const void *base,
+		size_t stride, uint32_t *next_hops, unsigned int n)
+{
+	const struct rte_lpm_tbl_entry *tbl8;
+	const struct iphdr *hdr;
+	unsigned int i = 0;
+
+	if ((lpm == NULL) || (base == NULL) || (next_hops == NULL))
+		return -EINVAL;
+
+	tbl8 = rte_lpm_tbl8(lpm);
+
+#if defined(__AVX2__)
+	/* Byte offsets of a group of 8 headers must fit a 32 bit gather. */
+	if (lpm_gather_ok(lpm) && stride <= (INT32_MAX - 64) / 8) {
+		const __m256i idx = _mm256_add_epi32(
+			_mm256_mullo_epi32(_mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0),
+				_mm256_set1_epi32((int)stride)),
+			_mm256_set1_epi32(offsetof(struct iphdr, daddr)));
+		const char *p = base;
+
+		for (; i + 8 <= n; i += 8, p += 8 * stride)
+			lpm_lookup_entry_x8(lpm, tbl8, lpm_bswap32_x8(
+				_mm256_i32gather_epi32((const int *)p, idx, 1)),
+				&next_hops[i]);
+	}
+#endif
+
+	for (; i < n; i++) {
+		hdr = (const struct iphdr *)((uintptr_t)base + i * stride);
+		next_hops[i] = lpm_lookup_entry(lpm, tbl8, ntohl(hdr->daddr));
+	}
+
+	if (lpm->nh_offset != 0)
+		lpm_lookup_bulk_resolve(lpm, NULL, next_hops, n);
+
+	return 0;
+}
+
+
+/*
+ * Points a next-hop id at a new next hop. Every route using the id moves
+ * with this single store (one per slot in ECMP mode); tbl24/tbl8 are not
+ * touched.
+ */
+int rte_lpm_nh_set(struct rte_lpm *lpm, uint32_t nh_id, uint32_t next_hop)
+{
+	return rte_lpm_ecmp_group_set(lpm, nh_id, &next_hop, NULL, 1);
+}
+
+
+int rte_lpm_nh_get(struct rte_lpm *lpm, uint32_t nh_id, uint32_t *next_hop)
+{
+	struct __rte_lpm *i_lpm;
+
+	if ((lpm == NULL) || (next_hop == NULL))
+		return -EINVAL;
+
+	i_lpm = container_of(lpm, struct __rte_lpm, lpm);
+	if ((lpm->nh_offset == 0) || (nh_id >= i_lpm->number_nh))
+		return -EINVAL;
+
+	*next_hop = __atomic_load_n(&rte_lpm_nh_tbl(lpm)
+			[nh_id << lpm->nh_slot_shift], __ATOMIC_ACQUIRE);
+	return 0;
+}
+
+
+/*
+ * Sets the members of an ECMP group. Slots of the group are spread over
+ * the members in proportion to their weight (equal weights if weights is
+ * NULL); a member whose share is below one slot gets none. Slots are
+ * updated one by one, so a concurrent lookup sees either the old or the
+ * new member of a slot.
+ */
+int rte_lpm_ecmp_group_set(struct rte_lpm *lpm, uint32_t nh_id,
+		const uint32_t *members, const uint32_t *weights, unsigned int n)
+{
+	uint64_t cum_weight[RTE_LPM_ECMP_MAX_MEMBERS];
+	uint64_t total = 0, pos;
+	struct __rte_lpm *i_lpm;
+	uint32_t *slots, nb_slots, s;
+	unsigned int i, m;
+
+	if ((lpm == NULL) || (members == NULL) || (n == 0))
+		return -EINVAL;
+
+	i_lpm = container_of(lpm, struct __rte_lpm, lpm);
+	nb_slots = 1U << lpm->nh_slot_shift;
+	if ((lpm->nh_offset == 0) || (nh_id >= i_lpm->number_nh) ||
+			(n > (nb_slots < RTE_LPM_ECMP_MAX_MEMBERS ?
+				nb_slots : RTE_LPM_ECMP_MAX_MEMBERS)))
+		return -EINVAL;
+
+	for (i = 0; i < n; i++) {
+		if (members[i] > RTE_LPM_MAX_NH ||
+				(weights != NULL && weights[i] == 0))
+			return -EINVAL;
+		total += weights != NULL ? weights[i] : 1;
+		cum_weight[i] = total;
+	}
+
+	slots = &rte_lpm_nh_tbl(lpm)[nh_id << lpm->nh_slot_shift];
+	for (s = 0, m = 0; s < nb_slots; s++) {
+		/* Slot s goes to the member covering its midpoint. */
+		pos = ((2 * (uint64_t)s + 1) * total) / (2 * nb_slots);
+		while (cum_weight[m] <= pos)
+			m++;
+		__atomic_store_n(&slots[s], members[m], __ATOMIC_RELEASE);
+	}
+
+	return 0;
+}
+
+
 /*
  * Checks if table 8 group can be recycled.
  *
@@ -659,18 +1282,23 @@ tbl8_recycle_check(struct rte_lpm_tbl_entry *tbl8,
 }
 
 
+/*
+ * tbl8_owner of a group that was freed but may still be read by lookups
+ * that loaded the old tbl24 entry, see rte_lpm_tbl8_reclaim().
+ */
+#define LPM_TBL8_RETIRED                0x80000000u
+#define LPM_TBL8_GRACE                  0x40000000u
+
 static int32_t
 tbl8_free(struct __rte_lpm *i_lpm, uint32_t tbl8_group_start)
 {
-	struct rte_lpm_tbl_entry zero_tbl8_entry = {0};
-	int status;
-
-/*
-	if (i_lpm->v == NULL) {
-		__atomic_store(&i_lpm->lpm.tbl8[tbl8_group_start], &zero_tbl8_entry,
-				__ATOMIC_RELAXED);
-	}
-*/
+	/*
+	 * The group is only retired: valid_group stays set so tbl8_alloc()
+	 * skips it and the entries stay unchanged for readers still walking
+	 * it. rte_lpm_tbl8_reclaim() makes it reusable after a grace period.
+	 */
+	i_lpm->tbl8_owner[tbl8_group_start / RTE_LPM_TBL8_GROUP_NUM_ENTRIES] =
+			LPM_TBL8_RETIRED;
 
 	return 0;
 }
@@ -917,12 +1545,44 @@ find_previous_rule(struct __rte_lpm *i_lpm, uint32_t ip, uint8_t depth,
 /*
  * Deletes a rule
  */
+static int32_t
+lpm_delete_rule(struct __rte_lpm *i_lpm, int32_t rule_to_delete_index,
+		uint32_t ip_masked, uint8_t depth)
+{
+	int32_t sub_rule_index;
+	uint8_t sub_rule_depth;
+
+	/* Delete the rule from the rule table. */
+	rule_delete(i_lpm, rule_to_delete_index, depth);
+
+	/*
+	 * Find rule to replace the rule_to_delete. If there is no rule to
+	 * replace the rule_to_delete we return -1 and invalidate the table
+	 * entries associated with this rule.
+	 */
+	sub_rule_depth = 0;
+	sub_rule_index = find_previous_rule(i_lpm, ip_masked, depth,
+			&sub_rule_depth);
+
+	/*
+	 * If the input depth value is less than 25 use function
+	 * delete_depth_small otherwise use delete_depth_big.
+	 */
+	if (depth <= MAX_DEPTH_TBL24) {
+		return delete_depth_small(i_lpm, ip_masked, depth,
+				sub_rule_index, sub_rule_depth);
+	} else { /* If depth > MAX_DEPTH_TBL24 */
+		return delete_depth_big(i_lpm, ip_masked, depth, sub_rule_index,
+				sub_rule_depth);
+	}
+}
+
+
 int rte_lpm_delete(struct rte_lpm *lpm, uint32_t ip, uint8_t depth)
 {
-	int32_t rule_to_delete_index, sub_rule_index;
+	int32_t rule_to_delete_index;
 	struct __rte_lpm *i_lpm;
 	uint32_t ip_masked;
-	uint8_t sub_rule_depth;
 	/*
 	 * Check input arguments. Note: IP must be a positive integer of 32
 	 * bits in length therefore it need not be checked.
@@ -947,30 +1607,584 @@ int rte_lpm_delete(struct rte_lpm *lpm, uint32_t ip, uint8_t depth)
 	if (rule_to_delete_index < 0)
 		return -EINVAL;
 
-	/* Delete the rule from the rule table. */
-	rule_delete(i_lpm, rule_to_delete_index, depth);
+	return lpm_delete_rule(i_lpm, rule_to_delete_index, ip_masked, depth);
+}
 
-	/*
-	 * Find rule to replace the rule_to_delete. If there is no rule to
-	 * replace the rule_to_delete we return -1 and invalidate the table
-	 * entries associated with this rule.
-	 */
-	sub_rule_depth = 0;
-	sub_rule_index = find_previous_rule(i_lpm, ip, depth, &sub_rule_depth);
 
-	/*
-	 * If the input depth value is less than 25 use function
-	 * delete_depth_small otherwise use delete_depth_big.
-	 */
+/*
+ * Depth of the rule stored at rule_index.
+ */
+static uint8_t
+rule_depth(struct __rte_lpm *i_lpm, uint32_t rule_index)
+{
+	uint8_t depth;
+
+	for (depth = 1; depth < RTE_LPM_MAX_DEPTH; depth++) {
+		if (rule_index < i_lpm->rule_info[depth - 1].first_rule +
+				i_lpm->rule_info[depth - 1].used_rules &&
+				i_lpm->rule_info[depth - 1].used_rules > 0)
+			break;
+	}
+
+	return depth;
+}
+
+
+/*
+ * Deletes every route via next_hop. Only the rules on the next hop list
+ * and the table ranges they cover are visited.
+ *
+ * @return
+ *   Number of routes deleted, -EINVAL if the lpm has no next hop index.
+ */
+int rte_lpm_delete_nh(struct rte_lpm *lpm, uint32_t next_hop)
+{
+	struct __rte_lpm *i_lpm;
+	uint32_t rule_index;
+	int32_t status;
+	int deleted = 0;
+
+	if (lpm == NULL)
+		return -EINVAL;
+
+	i_lpm = container_of(lpm, struct __rte_lpm, lpm);
+	if ((i_lpm->rule_links == NULL) || (next_hop >= i_lpm->number_nh))
+		return -EINVAL;
+
+	/* Deleting a rule unlinks it, so always take the list head. */
+	while (i_lpm->nh_heads[next_hop] != 0) {
+		rule_index = i_lpm->nh_heads[next_hop] - 1;
+		status = lpm_delete_rule(i_lpm, rule_index,
+				i_lpm->rules_tbl[rule_index].ip,
+				rule_depth(i_lpm, rule_index));
+		if (status < 0)
+			return status;
+		deleted++;
+	}
+
+	return deleted;
+}
+
+
+/*
+ * Moves every route via old_next_hop to new_next_hop, rewriting only the
+ * table entries of those routes.
+ *
+ * @return
+ *   Number of routes updated, -EINVAL for incorrect arguments or if the
+ *   lpm has no next hop index.
+ */
+int rte_lpm_replace_nh(struct rte_lpm *lpm, uint32_t old_next_hop,
+		uint32_t new_next_hop)
+{
+	struct __rte_lpm *i_lpm;
+	uint32_t rule_index, ip;
+	uint8_t depth;
+	int replaced = 0;
+
+	if (lpm == NULL)
+		return -EINVAL;
+
+	i_lpm = container_of(lpm, struct __rte_lpm, lpm);
+	if ((i_lpm->rule_links == NULL) ||
+			(old_next_hop >= i_lpm->number_nh) ||
+			(new_next_hop >= i_lpm->number_nh))
+		return -EINVAL;
+
+	if (old_next_hop == new_next_hop)
+		return 0;
+
+	while (i_lpm->nh_heads[old_next_hop] != 0) {
+		rule_index = i_lpm->nh_heads[old_next_hop] - 1;
+		ip = i_lpm->rules_tbl[rule_index].ip;
+		depth = rule_depth(i_lpm, rule_index);
+
+		rule_unlink(i_lpm, rule_index);
+		i_lpm->rules_tbl[rule_index].next_hop = new_next_hop;
+		rule_link(i_lpm, rule_index);
+
+		/*
+		 * The rule is installed, so every entry of its range that is
+		 * not covered by a longer rule already carries its depth and
+		 * is overwritten in place; no tbl8 group is allocated.
+		 */
+		if (depth <= MAX_DEPTH_TBL24)
+			add_depth_small(i_lpm, ip, depth, new_next_hop);
+		else
+			add_depth_big(i_lpm, ip, depth, new_next_hop);
+		replaced++;
+	}
+
+	return replaced;
+}
+
+/*
+ * Per thread state of a full table rebuild. Each thread owns a contiguous
+ * range of tbl24 and a contiguous slice of tbl8 groups, so no two threads
+ * ever write the same entry.
+ */
+struct lpm_rebuild_ctx {
+	pthread_t thread;
+	struct __rte_lpm *i_lpm;
+	uint32_t tbl24_start;   /**< First tbl24 index owned. */
+	uint32_t tbl24_end;     /**< One past the last tbl24 index owned. */
+	uint32_t *rules;        /**< Rule indexes touching the range. */
+	uint32_t nb_rules;
+	uint32_t tbl8_next;     /**< Next tbl8 group of the slice. */
+	uint32_t tbl8_end;      /**< One past the last group of the slice. */
+};
+
+
+static void
+rebuild_rule(struct lpm_rebuild_ctx *ctx, uint32_t rule_index, uint8_t depth)
+{
+	struct __rte_lpm *i_lpm = ctx->i_lpm;
+	struct rte_lpm_rule *rule = &i_lpm->rules_tbl[rule_index];
+	struct rte_lpm_tbl_entry *tbl24 = i_lpm->lpm.tbl24;
+	struct rte_lpm_tbl_entry *tbl8 = i_lpm->lpm.tbl8;
+	uint32_t tbl24_index, start, end, i;
+
+	tbl24_index = rule->ip >> 8;
+
 	if (depth <= MAX_DEPTH_TBL24) {
-		return delete_depth_small(i_lpm, ip_masked, depth,
-				sub_rule_index, sub_rule_depth);
-	} else { /* If depth > MAX_DEPTH_TBL24 */
-		return delete_depth_big(i_lpm, ip_masked, depth, sub_rule_index,
-				sub_rule_depth);
+		struct rte_lpm_tbl_entry new_tbl24_entry = {
+			.next_hop = rule->next_hop,
+			.valid = VALID,
+			.valid_group = 0,
+			.depth = depth,
+		};
+
+		/*
+		 * Rules are replayed shortest prefix first, so no tbl24 entry
+		 * is extended yet and longer prefixes simply overwrite.
+		 */
+		start = tbl24_index > ctx->tbl24_start ?
+				tbl24_index : ctx->tbl24_start;
+		end = tbl24_index + depth_to_range(depth);
+		if (end > ctx->tbl24_end)
+			end = ctx->tbl24_end;
+
+		for (i = start; i < end; i++)
+			tbl24[i] = new_tbl24_entry;
+		return;
+	}
+
+	if (!tbl24[tbl24_index].valid_group) {
+		/* Seed a group from the slice with the covering tbl24 entry. */
+		struct rte_lpm_tbl_entry new_tbl8_entry = {
+			.next_hop = tbl24[tbl24_index].next_hop,
+			.valid = tbl24[tbl24_index].valid,
+			.valid_group = 0,
+			.depth = tbl24[tbl24_index].depth,
+		};
+		struct rte_lpm_tbl_entry new_tbl24_entry = {
+			.next_hop = ctx->tbl8_next,
+			.valid = VALID,
+			.valid_group = 1,
+			.depth = 0,
+		};
+
+		start = ctx->tbl8_next * RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
+		for (i = start; i < start + RTE_LPM_TBL8_GROUP_NUM_ENTRIES; i++)
+			tbl8[i] = new_tbl8_entry;
+		tbl8[start].valid_group = VALID;
+
+		tbl24[tbl24_index] = new_tbl24_entry;
+		i_lpm->tbl8_owner[ctx->tbl8_next] = tbl24_index;
+		ctx->tbl8_next++;
 	}
+
+	start = tbl24[tbl24_index].next_hop * RTE_LPM_TBL8_GROUP_NUM_ENTRIES +
+			(rule->ip & 0xFF);
+	end = start + depth_to_range(depth);
+	for (i = start; i < end; i++) {
+		struct rte_lpm_tbl_entry new_tbl8_entry = {
+			.valid = VALID,
+			.depth = depth,
+			.valid_group = tbl8[i].valid_group,
+			.next_hop = rule->next_hop,
+		};
+
+		tbl8[i] = new_tbl8_entry;
+	}
+}
+
+
+static void *
+rebuild_thread(void *arg)
+{
+	struct lpm_rebuild_ctx *ctx = arg;
+	struct __rte_lpm *i_lpm = ctx->i_lpm;
+	uint32_t i, depth = 1, depth_end;
+
+	/* Clear the owned part of the tables. */
+	memset(&i_lpm->lpm.tbl24[ctx->tbl24_start], 0,
+		(size_t)(ctx->tbl24_end - ctx->tbl24_start) *
+		sizeof(struct rte_lpm_tbl_entry));
+	memset(&i_lpm->lpm.tbl8[(size_t)ctx->tbl8_next *
+			RTE_LPM_TBL8_GROUP_NUM_ENTRIES], 0,
+		(size_t)(ctx->tbl8_end - ctx->tbl8_next) *
+		RTE_LPM_TBL8_GROUP_NUM_ENTRIES *
+		sizeof(struct rte_lpm_tbl_entry));
+	/* Drops retired marks, the rebuild frees every group. */
+	memset(&i_lpm->tbl8_owner[ctx->tbl8_next], 0,
+		(size_t)(ctx->tbl8_end - ctx->tbl8_next) *
+		sizeof(i_lpm->tbl8_owner[0]));
+
+	/* Bucketed rule indexes are in rules_tbl, i.e. depth, order. */
+	depth_end = i_lpm->rule_info[0].first_rule +
+			i_lpm->rule_info[0].used_rules;
+	for (i = 0; i < ctx->nb_rules; i++) {
+		while (ctx->rules[i] >= depth_end ||
+				ctx->rules[i] < i_lpm->rule_info[depth - 1].first_rule) {
+			depth++;
+			depth_end = i_lpm->rule_info[depth - 1].first_rule +
+					i_lpm->rule_info[depth - 1].used_rules;
+		}
+		rebuild_rule(ctx, ctx->rules[i], depth);
+	}
+
+	return NULL;
 }
 
+
+/*
+ * Rebuilds tbl24 and tbl8 from the rule table using nb_threads threads.
+ *
+ * The 2^24 tbl24 space is split into nb_threads ranges. Rules are bucketed
+ * by the ranges they cover and each thread replays its bucket shortest
+ * prefix first into its own range, allocating tbl8 groups from a private
+ * slice of the pool sized up front. Lookups must not run concurrently
+ * with a rebuild.
+ *
+ * @return
+ *   0 on success, -EINVAL for incorrect arguments, -ENOSPC if the rules
+ *   need more tbl8 groups than configured, -ENOMEM on allocation failure.
+ *   On error the tables are left untouched.
+ */
+int
+rte_lpm_rebuild(struct rte_lpm *lpm, unsigned int nb_threads)
+{
+	struct lpm_rebuild_ctx *ctx;
+	struct __rte_lpm *i_lpm;
+	uint32_t *tbl8_map = NULL;
+	uint32_t range, rule_index, first, last, tbl24_index, tbl8_total, t;
+	unsigned int started = 0;
+	int depth, status = 0;
+
+	if ((lpm == NULL) || (nb_threads == 0) ||
+			(nb_threads > RTE_LPM_REBUILD_MAX_THREADS))
+		return -EINVAL;
+
+	i_lpm = container_of(lpm, struct __rte_lpm, lpm);
+	range = (RTE_LPM_TBL24_NUM_ENTRIES + nb_threads - 1) / nb_threads;
+
+	ctx = calloc(nb_threads, sizeof(*ctx));
+	/* One bit per tbl24 entry that needs a tbl8 group. */
+	tbl8_map = calloc(RTE_LPM_TBL24_NUM_ENTRIES / 32, sizeof(uint32_t));
+	if (ctx == NULL || tbl8_map == NULL) {
+		status = -ENOMEM;
+		goto exit;
+	}
+
+	for (t = 0; t < nb_threads; t++) {
+		ctx[t].i_lpm = i_lpm;
+		ctx[t].tbl24_start = t * range;
+		ctx[t].tbl24_end = (t == nb_threads - 1) ?
+				RTE_LPM_TBL24_NUM_ENTRIES : (t + 1) * range;
+	}
+
+	/* Count the rules and the tbl8 groups of every range. */
+	for (depth = 1; depth <= RTE_LPM_MAX_DEPTH; depth++) {
+		first = i_lpm->rule_info[depth - 1].first_rule;
+		last = first + i_lpm->rule_info[depth - 1].used_rules;
+
+		for (rule_index = first; rule_index < last; rule_index++) {
+			tbl24_index = i_lpm->rules_tbl[rule_index].ip >> 8;
+
+			if (depth <= MAX_DEPTH_TBL24) {
+				uint32_t end = tbl24_index + depth_to_range(depth);
+
+				for (t = tbl24_index / range;
+						t < nb_threads && t * range < end; t++)
+					ctx[t].nb_rules++;
+				continue;
+			}
+
+			t = tbl24_index / range;
+			ctx[t].nb_rules++;
+			if (!(tbl8_map[tbl24_index / 32] &
+					(1U << (tbl24_index % 32)))) {
+				tbl8_map[tbl24_index / 32] |=
+						1U << (tbl24_index % 32);
+				ctx[t].tbl8_end++;
+			}
+		}
+	}
+
+	/* Hand out contiguous tbl8 slices and the bucket arrays. */
+	tbl8_total = 0;
+	for (t = 0; t < nb_threads; t++) {
+		ctx[t].tbl8_next = tbl8_total;
+		tbl8_total += ctx[t].tbl8_end;
+		ctx[t].tbl8_end = tbl8_total;
+
+		ctx[t].rules = malloc(((size_t)ctx[t].nb_rules + 1) *
+				sizeof(uint32_t));
+		if (ctx[t].rules == NULL) {
+			status = -ENOMEM;
+			goto exit;
+		}
+		ctx[t].nb_rules = 0;
+	}
+
+	if (tbl8_total > i_lpm->number_tbl8s) {
+		status = -ENOSPC;
+		goto exit;
+	}
+
+	for (depth = 1; depth <= RTE_LPM_MAX_DEPTH; depth++) {
+		first = i_lpm->rule_info[depth - 1].first_rule;
+		last = first + i_lpm->rule_info[depth - 1].used_rules;
+
+		for (rule_index = first; rule_index < last; rule_index++) {
+			tbl24_index = i_lpm->rules_tbl[rule_index].ip >> 8;
+			t = tbl24_index / range;
+
+			if (depth <= MAX_DEPTH_TBL24) {
+				uint32_t end = tbl24_index + depth_to_range(depth);
+
+				for (; t < nb_threads && t * range < end; t++)
+					ctx[t].rules[ctx[t].nb_rules++] = rule_index;
+			} else
+				ctx[t].rules[ctx[t].nb_rules++] = rule_index;
+		}
+	}
+
+	/* Groups left over after the slices become free. */
+	memset(&lpm->tbl8[(size_t)tbl8_total * RTE_LPM_TBL8_GROUP_NUM_ENTRIES],
+		0, (size_t)(i_lpm->number_tbl8s - tbl8_total) *
+		RTE_LPM_TBL8_GROUP_NUM_ENTRIES *
+		sizeof(struct rte_lpm_tbl_entry));
+
+	for (t = 1; t < nb_threads; t++) {
+		if (pthread_create(&ctx[t].thread, NULL, rebuild_thread,
+				&ctx[t]) != 0)
+			break;
+		started++;
+	}
+	/* Ranges without a thread are rebuilt by the caller. */
+	for (t = started + 1; t < nb_threads; t++)
+		rebuild_thread(&ctx[t]);
+	rebuild_thread(&ctx[0]);
+
+	for (t = 1; t <= started; t++)
+		pthread_join(ctx[t].thread, NULL);
+
+	/* Groups are handed out in tbl24 order, the pool is compact. */
+	i_lpm->compact_tbl24 = 0;
+	i_lpm->compact_next = 0;
+
+	/* Make the rebuilt tables visible before any later lookup. */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+exit:
+	if (ctx != NULL) {
+		for (t = 0; t < nb_threads; t++)
+			free(ctx[t].rules);
+		free(ctx);
+	}
+	free(tbl8_map);
+	return status;
+}
+
+
+/*
+ * Relocates a live tbl8 group into the free group dst. The copy is
+ * complete before the tbl24 entry is switched with a release store, and
+ * the old group is only retired, so a concurrent lookup reads consistent
+ * entries from either group.
+ */
+static void
+tbl8_move(struct __rte_lpm *i_lpm, uint32_t dst, uint32_t src)
+{
+#define group_idx next_hop
+	struct rte_lpm_tbl_entry *tbl8 = i_lpm->lpm.tbl8;
+	uint32_t tbl24_index = i_lpm->tbl8_owner[src];
+	uint32_t i, src_start, dst_start;
+
+	src_start = src * RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
+	dst_start = dst * RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
+
+	for (i = 0; i < RTE_LPM_TBL8_GROUP_NUM_ENTRIES; i++)
+		__atomic_store(&tbl8[dst_start + i], &tbl8[src_start + i],
+				__ATOMIC_RELAXED);
+	i_lpm->tbl8_owner[dst] = tbl24_index;
+
+	struct rte_lpm_tbl_entry new_tbl24_entry = {
+		.group_idx = dst,
+		.valid = VALID,
+		.valid_group = 1,
+		.depth = 0,
+	};
+
+	__atomic_store(&i_lpm->lpm.tbl24[tbl24_index], &new_tbl24_entry,
+			__ATOMIC_RELEASE);
+
+	tbl8_free(i_lpm, src_start);
+#undef group_idx
+}
+
+
+/*
+ * Incremental tbl8 compaction.
+ *
+ * Walks tbl24 in index order and relocates the tbl8 group of every
+ * extended entry to the next slot of a dense prefix of the pool, so the
+ * groups of neighbouring tbl24 entries end up next to each other. Progress
+ * is kept in the lpm, every call does at most max_work units (one per
+ * tbl24 entry or free slot scanned, RTE_LPM_TBL8_GROUP_NUM_ENTRIES per
+ * group moved). Must be serialized with rte_lpm_add/rte_lpm_delete.
+ *
+ * A group is only ever moved into a free group. When another group
+ * occupies the target slot, it is moved out to the highest free group and
+ * the slot is retired like any freed group: lookups may still be reading
+ * it. The pass then stops with -EAGAIN until rte_lpm_tbl8_reclaim() has
+ * released the slot, so concurrent lookups never see a group overwritten
+ * under them.
+ *
+ * @return
+ *   1 when a full pass is complete, 0 if more work remains, -EAGAIN if the
+ *   pass waits for a retired group (call rte_lpm_tbl8_reclaim() as
+ *   documented there, then resume), -EINVAL for incorrect arguments.
+ */
+int
+rte_lpm_tbl8_compact(struct rte_lpm *lpm, uint32_t max_work)
+{
+	struct rte_lpm_tbl_entry *tbl8;
+	struct __rte_lpm *i_lpm;
+	uint32_t tbl24_index, group, target, free_group;
+	uint32_t work = 0;
+
+	if ((lpm == NULL) || (max_work == 0))
+		return -EINVAL;
+
+	i_lpm = container_of(lpm, struct __rte_lpm, lpm);
+	tbl8 = lpm->tbl8;
+
+	while (work < max_work) {
+		if (i_lpm->compact_tbl24 == RTE_LPM_TBL24_NUM_ENTRIES) {
+			i_lpm->compact_tbl24 = 0;
+			i_lpm->compact_next = 0;
+			return 1;
+		}
+
+		tbl24_index = i_lpm->compact_tbl24++;
+		work++;
+
+		if (!lpm->tbl24[tbl24_index].valid ||
+				!lpm->tbl24[tbl24_index].valid_group)
+			continue;
+
+		group = lpm->tbl24[tbl24_index].next_hop; /* group index */
+		target = i_lpm->compact_next;
+
+		/* Already part of the dense prefix. */
+		if (group <= target) {
+			if (group == target)
+				i_lpm->compact_next++;
+			continue;
+		}
+
+		if (tbl8[target * RTE_LPM_TBL8_GROUP_NUM_ENTRIES].valid_group) {
+			/* Resume from this tbl24 entry once target is free. */
+			i_lpm->compact_tbl24--;
+
+			/* Retired, readers may still be walking it. */
+			if (i_lpm->tbl8_owner[target] &
+					(LPM_TBL8_RETIRED | LPM_TBL8_GRACE))
+				return -EAGAIN;
+
+			/* Make room: evict to the highest free group. */
+			for (free_group = i_lpm->number_tbl8s - 1;
+					free_group > target; free_group--, work++) {
+				if (!tbl8[free_group *
+					RTE_LPM_TBL8_GROUP_NUM_ENTRIES].valid_group)
+					break;
+			}
+
+			/* The pool is full, nothing can be relocated. */
+			if (free_group == target) {
+				i_lpm->compact_tbl24 = 0;
+				i_lpm->compact_next = 0;
+				return 1;
+			}
+
+			/* Retires target, it is filled after a grace period. */
+			tbl8_move(i_lpm, free_group, target);
+			return -EAGAIN;
+		}
+
+		tbl8_move(i_lpm, target, group);
+		work += RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
+		i_lpm->compact_next++;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Releases retired tbl8 groups for reuse.
+ *
+ * Deleting routes and compaction retire tbl8 groups instead of freeing
+ * them, because a lookup that loaded the old tbl24 entry may still be
+ * reading the group. Retired groups are never reallocated until released
+ * here, so without calls to this function freed groups are not reused.
+ *
+ * The caller must ensure a grace period between two consecutive calls:
+ * every lookup running at the time of one call has completed before the
+ * next call starts (e.g. every reader thread went through a quiescent
+ * state, or readers take the same lock as the writer). A group retired
+ * before call n is then released by call n + 1. Must be serialized with
+ * rte_lpm_add/rte_lpm_delete.
+ *
+ * @return
+ *   Number of groups released, -EINVAL for incorrect arguments.
+ */
+int
+rte_lpm_tbl8_reclaim(struct rte_lpm *lpm)
+{
+	struct rte_lpm_tbl_entry tbl8_entry;
+	struct __rte_lpm *i_lpm;
+	uint32_t group, start;
+	int released = 0;
+
+	if (lpm == NULL)
+		return -EINVAL;
+
+	i_lpm = container_of(lpm, struct __rte_lpm, lpm);
+
+	for (group = 0; group < i_lpm->number_tbl8s; group++) {
+		if (i_lpm->tbl8_owner[group] == LPM_TBL8_RETIRED) {
+			/* No reader started after this call can reach it. */
+			i_lpm->tbl8_owner[group] = LPM_TBL8_GRACE;
+		} else if (i_lpm->tbl8_owner[group] == LPM_TBL8_GRACE) {
+			/* A grace period passed since it was unreachable. */
+			start = group * RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
+			tbl8_entry = lpm->tbl8[start];
+			tbl8_entry.valid_group = INVALID;
+			__atomic_store(&lpm->tbl8[start], &tbl8_entry,
+					__ATOMIC_RELAXED);
+			i_lpm->tbl8_owner[group] = 0;
+			released++;
+		}
+	}
+
+	return released;
+}
+
+
 void rte_lpm_dump(struct rte_lpm *lpm){
 	struct __rte_lpm *i_lpm;
 	struct rte_lpm_rule_info  *rule_info;
@@ -986,6 +2200,362 @@ void rte_lpm_dump(struct rte_lpm *lpm){
 	return;
 }
 
+
+static int
+route_cmp(const void *a, const void *b)
+{
+	const struct rte_lpm_route *x = a, *y = b;
+
+	if (x->ip != y->ip)
+		return x->ip < y->ip ? -1 : 1;
+	if (x->depth != y->depth)
+		return x->depth < y->depth ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Copies up to n routes of the depth order walk, starting at the cursor.
+ */
+static unsigned int
+iter_depth_bulk(struct rte_lpm_iter *iter, struct rte_lpm_route *routes,
+		unsigned int n)
+{
+	struct __rte_lpm *i_lpm;
+	const struct rte_lpm_rule *rule;
+	uint32_t used, nb;
+	unsigned int count = 0;
+
+	i_lpm = container_of(iter->lpm, struct __rte_lpm, lpm);
+
+	while (count < n && iter->depth <= RTE_LPM_MAX_DEPTH) {
+		used = i_lpm->rule_info[iter->depth - 1].used_rules;
+		if (iter->pos >= used) {
+			iter->depth++;
+			iter->pos = 0;
+			continue;
+		}
+
+		nb = used - iter->pos;
+		if (nb > n - count)
+			nb = n - count;
+
+		rule = &i_lpm->rules_tbl[i_lpm->rule_info[iter->depth - 1].first_rule
+				+ iter->pos];
+		iter->pos += nb;
+		for (; nb > 0; nb--, rule++, count++) {
+			routes[count].ip = rule->ip;
+			routes[count].depth = iter->depth;
+			routes[count].next_hop = rule->next_hop;
+		}
+	}
+
+	return count;
+}
+
+/*
+ * Starts a walk over the installed routes.
+ *
+ * RTE_LPM_ITER_DEPTH reads the rules table in place, depth by depth, and
+ * never blocks lookups. Rules added or deleted while the walk is between
+ * calls may be missed or returned twice, as deletes move the last rule of
+ * a depth into the freed slot. RTE_LPM_ITER_ADDR copies the rules once,
+ * sorts them by address then depth and walks the copy, so it returns a
+ * consistent view as of rte_lpm_iter_init().
+ */
+int
+rte_lpm_iter_init(struct rte_lpm_iter *iter, struct rte_lpm *lpm, int order)
+{
+	struct __rte_lpm *i_lpm;
+	uint32_t nb_routes = 0;
+	int i;
+
+	if ((iter == NULL) || (lpm == NULL) ||
+			((order != RTE_LPM_ITER_DEPTH) && (order != RTE_LPM_ITER_ADDR)))
+		return -EINVAL;
+
+	memset(iter, 0, sizeof(*iter));
+	iter->lpm = lpm;
+	iter->order = order;
+	iter->depth = 1;
+
+	if (order == RTE_LPM_ITER_DEPTH)
+		return 0;
+
+	i_lpm = container_of(lpm, struct __rte_lpm, lpm);
+	for (i = 0; i < RTE_LPM_MAX_DEPTH; i++)
+		nb_routes += i_lpm->rule_info[i].used_rules;
+
+	iter->snapshot = malloc((nb_routes + 1) * sizeof(*iter->snapshot));
+	if (iter->snapshot == NULL)
+		return -ENOMEM;
+
+	iter->nb_routes = iter_depth_bulk(iter, iter->snapshot, nb_routes);
+	qsort(iter->snapshot, iter->nb_routes, sizeof(*iter->snapshot),
+			route_cmp);
+	iter->pos = 0;
+
+	return 0;
+}
+
+/*
+ * Returns the next route, or -ENOENT once the walk is over.
+ */
+int
+rte_lpm_iter_next(struct rte_lpm_iter *iter, struct rte_lpm_route *route)
+{
+	int ret;
+
+	ret = rte_lpm_iter_bulk(iter, route, 1);
+	if (ret < 0)
+		return ret;
+
+	return (ret == 0) ? -ENOENT : 0;
+}
+
+/*
+ * Exports up to n routes into the caller buffer. Returns the number of
+ * routes written, 0 once the walk is over.
+ */
+int
+rte_lpm_iter_bulk(struct rte_lpm_iter *iter, struct rte_lpm_route *routes,
+		unsigned int n)
+{
+	uint32_t nb;
+
+	if ((iter == NULL) || (iter->lpm == NULL) || (routes == NULL))
+		return -EINVAL;
+
+	if (iter->order == RTE_LPM_ITER_DEPTH)
+		return iter_depth_bulk(iter, routes, n);
+
+	nb = iter->nb_routes - iter->pos;
+	if (nb > n)
+		nb = n;
+	memcpy(routes, &iter->snapshot[iter->pos], nb * sizeof(*routes));
+	iter->pos += nb;
+
+	return nb;
+}
+
+void
+rte_lpm_iter_fini(struct rte_lpm_iter *iter)
+{
+	if (iter == NULL)
+		return;
+
+	free(iter->snapshot);
+	memset(iter, 0, sizeof(*iter));
+}
+
+
+/*
+ * Takes ownership of writes on a shared lpm. An owner that died without
+ * detaching is replaced.
+ */
+static int
+lpm_shm_claim(struct __rte_lpm *i_lpm)
+{
+	int32_t owner, self = (int32_t)getpid();
+
+	owner = __atomic_load_n(&i_lpm->owner_pid, __ATOMIC_ACQUIRE);
+	do {
+		if (owner == self)
+			return 0;
+		if (owner != 0 && (kill(owner, 0) == 0 || errno != ESRCH))
+			return -EBUSY;
+	} while (!__atomic_compare_exchange_n(&i_lpm->owner_pid, &owner, self,
+			0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	return 0;
+}
+
+
+static void
+lpm_shm_name(char *buf, size_t len, const char *name)
+{
+	snprintf(buf, len, "/LPM_%s", name);
+}
+
+
+/*
+ * Creates an LPM object in the shared memory object referred to by fd
+ * (shm_open or memfd_create). The calling process owns writes.
+ */
+struct rte_lpm *
+rte_lpm_create_fd(int fd, const char *name, const struct rte_lpm_config *config)
+{
+	struct lpm_mem_layout layout;
+	struct __rte_lpm *i_lpm;
+	void *mem;
+
+	/* Check user arguments. */
+	if ((fd < 0) || (name == NULL) || lpm_mem_layout(config, &layout) < 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	/* A freshly sized object reads back as zero, as calloc does. */
+	if (ftruncate(fd, 0) < 0 || ftruncate(fd, layout.mem_size) < 0) {
+		printf("LPM shared memory sizing failed\n");
+		return NULL;
+	}
+
+	mem = mmap(NULL, layout.mem_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			fd, 0);
+	if (mem == MAP_FAILED) {
+		printf("LPM shared memory mapping failed\n");
+		return NULL;
+	}
+
+	i_lpm = mem;
+	i_lpm->shm = 1;
+	i_lpm->owner_pid = (int32_t)getpid();
+
+	return lpm_init(mem, name, config, &layout);
+}
+
+
+struct rte_lpm *
+rte_lpm_shm_create(const char *name, const struct rte_lpm_config *config)
+{
+	char mem_name[RTE_LPM_NAMESIZE + 8];
+	struct rte_lpm *lpm;
+	int fd;
+
+	if (name == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	lpm_shm_name(mem_name, sizeof(mem_name), name);
+	fd = shm_open(mem_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd < 0)
+		return NULL;
+
+	lpm = rte_lpm_create_fd(fd, name, config);
+	if (lpm == NULL)
+		shm_unlink(mem_name);
+
+	/* The mapping keeps the object alive. */
+	close(fd);
+	return lpm;
+}
+
+
+/*
+ * Maps an existing shared LPM object. RTE_LPM_SHM_RDONLY handles may only be
+ * used for lookups; an RTE_LPM_SHM_RDWR handle becomes the single writer.
+ */
+struct rte_lpm *
+rte_lpm_attach_fd(int fd, int flags)
+{
+	struct __rte_lpm *i_lpm;
+	struct stat st;
+	void *mem;
+	int prot, ret;
+
+	if ((fd < 0) || (flags != RTE_LPM_SHM_RDONLY &&
+			flags != RTE_LPM_SHM_RDWR)) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if (fstat(fd, &st) < 0)
+		return NULL;
+	if ((size_t)st.st_size < sizeof(struct __rte_lpm)) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	prot = PROT_READ;
+	if (flags == RTE_LPM_SHM_RDWR)
+		prot |= PROT_WRITE;
+
+	mem = mmap(NULL, st.st_size, prot, MAP_SHARED, fd, 0);
+	if (mem == MAP_FAILED)
+		return NULL;
+
+	i_lpm = mem;
+	if (__atomic_load_n(&i_lpm->magic, __ATOMIC_ACQUIRE) != RTE_LPM_MAGIC ||
+			i_lpm->mem_size != (uint64_t)st.st_size) {
+		munmap(mem, st.st_size);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if (flags == RTE_LPM_SHM_RDWR) {
+		ret = lpm_shm_claim(i_lpm);
+		if (ret < 0) {
+			munmap(mem, st.st_size);
+			errno = -ret;
+			return NULL;
+		}
+		/* Only the writer dereferences the table pointers. */
+		lpm_set_pointers(i_lpm);
+	}
+
+	return &i_lpm->lpm;
+}
+
+
+struct rte_lpm *
+rte_lpm_shm_attach(const char *name, int flags)
+{
+	char mem_name[RTE_LPM_NAMESIZE + 8];
+	struct rte_lpm *lpm;
+	int fd;
+
+	if (name == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	lpm_shm_name(mem_name, sizeof(mem_name), name);
+	fd = shm_open(mem_name,
+			flags == RTE_LPM_SHM_RDWR ? O_RDWR : O_RDONLY, 0);
+	if (fd < 0)
+		return NULL;
+
+	lpm = rte_lpm_attach_fd(fd, flags);
+	close(fd);
+	return lpm;
+}
+
+
+/*
+ * Unmaps a shared LPM object, giving up write ownership if held.
+ */
+void
+rte_lpm_shm_detach(struct rte_lpm *lpm)
+{
+	struct __rte_lpm *i_lpm;
+	int32_t self;
+
+	if (lpm == NULL)
+		return;
+
+	i_lpm = container_of(lpm, struct __rte_lpm, lpm);
+	self = (int32_t)getpid();
+	if (__atomic_load_n(&i_lpm->owner_pid, __ATOMIC_RELAXED) == self)
+		__atomic_compare_exchange_n(&i_lpm->owner_pid, &self, 0, 0,
+				__ATOMIC_RELEASE, __ATOMIC_RELAXED);
+
+	munmap(i_lpm, i_lpm->mem_size);
+}
+
+
+int
+rte_lpm_shm_unlink(const char *name)
+{
+	char mem_name[RTE_LPM_NAMESIZE + 8];
+
+	if (name == NULL)
+		return -EINVAL;
+
+	lpm_shm_name(mem_name, sizeof(mem_name), name);
+	return shm_unlink(mem_name) < 0 ? -errno : 0;
+}
+
 #if 0
 int main(int argc, char** argv){
 
@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stdarg.h>
 #include <stddef.h>
+#include <netinet/ip.h>
 
 #define MAX_DEPTH_TBL24 24
 
@@ -40,8 +41,6 @@
 #ifndef container_of
 #define container_of(ptr, type, member)	__extension__ ({		\
 			const typeof(((type *)0)->member) *_ptr = (ptr); \
-			 type *_target_ptr =	\
-				(type *)(ptr);				\
 			(type *)(((uintptr_t)_ptr) - offsetof(type, member)); \
 		})
 #endif
@@ -53,16 +52,63 @@
 /** Bitmask used to indicate successful lookup */
 #define RTE_LPM_LOOKUP_SUCCESS          0x01000000
 
+/** Largest next hop, and largest number of next-hop ids. */
+#define RTE_LPM_MAX_NH                  0x00FFFFFF
+
+/** Max number of threads used by rte_lpm_rebuild(). */
+#define RTE_LPM_REBUILD_MAX_THREADS     64
+
+/** @internal Marks a fully initialised lpm memory block. */
+#define RTE_LPM_MAGIC                   0x4c504d31
+
+/** Attach a shared lpm for lookups only. */
+#define RTE_LPM_SHM_RDONLY              0
+/** Attach a shared lpm and take ownership of writes. */
+#define RTE_LPM_SHM_RDWR                1
+
 enum valid_flag {
 	INVALID = 0,
 	VALID
 };
 
+/**
+ * Table entries hold a next-hop id instead of a next hop. The id is
+ * resolved through a small next-hop table that can be re-pointed with
+ * rte_lpm_nh_set() without touching tbl24/tbl8.
+ */
+#define RTE_LPM_F_NH_INDIRECT           0x0001
+
+/**
+ * Next-hop ids refer to ECMP groups (implies RTE_LPM_F_NH_INDIRECT). Each
+ * group spreads RTE_LPM_ECMP_SLOTS slots over its members by weight and
+ * rte_lpm_lookup_bulk_hash() picks a slot from the packet flow hash.
+ */
+#define RTE_LPM_F_ECMP                  0x0002
+
+/**
+ * Keep a per next hop list of the rules using it (next hops below
+ * config.number_nh), for rte_lpm_delete_nh() and rte_lpm_replace_nh().
+ */
+#define RTE_LPM_F_NH_INDEX              0x0004
+
+/** Max number of members in an ECMP group. */
+#define RTE_LPM_ECMP_MAX_MEMBERS        16
+
+/** log2 of the number of hash slots of an ECMP group. */
+#define RTE_LPM_ECMP_SLOTS_LOG2         6
+#define RTE_LPM_ECMP_SLOTS              (1 << RTE_LPM_ECMP_SLOTS_LOG2)
+
+/** Iterate routes by increasing depth, reading the rules table live. */
+#define RTE_LPM_ITER_DEPTH              0
+/** Iterate routes by increasing address from a snapshot of the rules. */
+#define RTE_LPM_ITER_ADDR               1
+
 /** LPM configuration structure. */
 struct rte_lpm_config {
 	uint32_t max_rules;      /**< Max number of rules. */
 	uint32_t number_tbl8s;   /**< Number of tbl8s to allocate. */
-	int flags;               /**< This field is currently unused. */
+	int flags;               /**< RTE_LPM_F_* flags. */
+	uint32_t number_nh;      /**< Number of next-hop ids (indirect mode). */
 };
 
 
@@ -90,7 +136,30 @@ struct rte_lpm_tbl_entry {
 struct rte_lpm {
 	/* LPM Tables. */
 	struct rte_lpm_tbl_entry tbl24[RTE_LPM_TBL24_NUM_ENTRIES];
-	struct rte_lpm_tbl_entry *tbl8; /**< LPM tbl8 table. */
+	struct rte_lpm_tbl_entry *tbl8; /**< LPM tbl8 table (writer mapping). */
+	uint64_t tbl8_offset; /**< Offset of tbl8 from the table base. */
+	uint64_t nh_offset; /**< Offset of the next-hop table, 0 if direct. */
+	uint32_t nh_slot_shift; /**< log2 of the slots per next-hop id. */
+};
+
+/** Route yielded by the FIB iterator. */
+struct rte_lpm_route {
+	uint32_t ip;       /**< Prefix, host byte order. */
+	uint8_t depth;     /**< Prefix length. */
+	uint32_t next_hop; /**< Next hop (or next-hop id) of the rule. */
+};
+
+/**
+ * FIB iterator cursor. It only holds plain positions, so an export can be
+ * stopped and resumed on later calls from the same cursor.
+ */
+struct rte_lpm_iter {
+	struct rte_lpm *lpm;
+	int order;         /**< RTE_LPM_ITER_DEPTH or RTE_LPM_ITER_ADDR. */
+	uint32_t depth;    /**< Current depth (depth order). */
+	uint32_t pos;      /**< Position in the depth group or snapshot. */
+	uint32_t nb_routes; /**< Number of routes in the snapshot. */
+	struct rte_lpm_route *snapshot; /**< Sorted routes (address order). */
 };
 
 /** @internal Rule structure. */
@@ -99,6 +168,15 @@ struct rte_lpm_rule {
 	uint32_t next_hop; /**< Rule next hop. */
 };
 
+/**
+ * @internal Links of a rule in the list of its next hop. Links hold a rule
+ * index plus one, 0 ends the list.
+ */
+struct rte_lpm_rule_link {
+	uint32_t prev;
+	uint32_t next;
+};
+
 /** @internal Contains metadata about the rules table. */
 struct rte_lpm_rule_info {
 	uint32_t used_rules; /**< Used rules so far. */
@@ -114,21 +192,117 @@ struct __rte_lpm {
 	char name[RTE_LPM_NAMESIZE];        /**< Name of the lpm. */
 	uint32_t max_rules; /**< Max. balanced rules per lpm. */
 	uint32_t number_tbl8s; /**< Number of tbl8s. */
+	uint32_t number_nh; /**< Number of next-hop ids, 0 if direct. */
 	/**< Rule info table. */
 	struct rte_lpm_rule_info rule_info[RTE_LPM_MAX_DEPTH];
-	struct rte_lpm_rule *rules_tbl; /**< LPM rules. */
+	struct rte_lpm_rule *rules_tbl; /**< LPM rules (writer mapping). */
+	uint64_t rules_offset; /**< Offset of rules_tbl from the table base. */
+
+	/* Next hop index, RTE_LPM_F_NH_INDEX only. */
+	struct rte_lpm_rule_link *rule_links; /**< Links, one per rule. */
+	uint32_t *nh_heads; /**< First rule of every next hop. */
+	uint64_t links_offset; /**< Offset of rule_links, 0 if no index. */
+	uint64_t nh_heads_offset; /**< Offset of nh_heads. */
+
+	/* tbl8 group owners and rte_lpm_tbl8_compact() progress. */
+	uint32_t *tbl8_owner; /**< tbl24 index using every tbl8 group. */
+	uint64_t tbl8_owner_offset; /**< Offset of tbl8_owner. */
+	uint32_t compact_tbl24; /**< Next tbl24 index to compact. */
+	uint32_t compact_next; /**< Next tbl8 group of the dense prefix. */
+
+	/* Memory block metadata. */
+	uint32_t magic;     /**< RTE_LPM_MAGIC once initialised. */
+	uint32_t shm;       /**< Block lives in a shared memory mapping. */
+	uint64_t mem_size;  /**< Size of the block holding all the tables. */
+	int32_t owner_pid;  /**< Process owning writes on a shared lpm. */
 };
 
+/**
+ * @internal tbl8 resolved through its offset from the table base, so the
+ * lookup path stays valid whatever address the table is mapped at.
+ */
+static inline const struct rte_lpm_tbl_entry *
+rte_lpm_tbl8(const struct rte_lpm *lpm)
+{
+	return (const struct rte_lpm_tbl_entry *)((uintptr_t)lpm +
+			lpm->tbl8_offset);
+}
+
+/** @internal Next-hop table of an RTE_LPM_F_NH_INDIRECT lpm. */
+static inline uint32_t *
+rte_lpm_nh_tbl(const struct rte_lpm *lpm)
+{
+	return (uint32_t *)((uintptr_t)lpm + lpm->nh_offset);
+}
+
 struct rte_lpm *rte_lpm_create(const char *name, const struct rte_lpm_config *config);
 
 int rte_lpm_add(struct rte_lpm *lpm, uint32_t ip, uint8_t depth,
 		uint32_t next_hop);
 
  int rte_lpm_lookup(struct rte_lpm *lpm, uint32_t ip, uint32_t *next_hop);
+
+int rte_lpm_lookup_bulk(struct rte_lpm *lpm, const uint32_t *ips,
+		uint32_t *next_hops, unsigned int n);
+
+int rte_lpm_nh_set(struct rte_lpm *lpm, uint32_t nh_id, uint32_t next_hop);
+
+int rte_lpm_nh_get(struct rte_lpm *lpm, uint32_t nh_id, uint32_t *next_hop);
+
+int rte_lpm_ecmp_group_set(struct rte_lpm *lpm, uint32_t nh_id,
+		const uint32_t *members, const uint32_t *weights, unsigned int n);
+
+int rte_lpm_lookup_bulk_hash(struct rte_lpm *lpm, const uint32_t *ips,
+		const uint32_t *hashes, uint32_t *next_hops, unsigned int n);
+
+int rte_lpm_lookup_bulk_ipv4(struct rte_lpm *lpm,
+		const struct iphdr *const *hdrs, uint32_t *next_hops,
+		unsigned int n);
+
+int rte_lpm_lookup_bulk_ipv4_stride(struct rte_lpm *lpm, const void *base,
+		size_t stride, uint32_t *next_hops, unsigned int n);
  
 int rte_lpm_delete(struct rte_lpm *lpm, uint32_t ip, uint8_t depth);
 
+int rte_lpm_delete_nh(struct rte_lpm *lpm, uint32_t next_hop);
+
+int rte_lpm_replace_nh(struct rte_lpm *lpm, uint32_t old_next_hop,
+		uint32_t new_next_hop);
+
 void rte_lpm_dump(struct rte_lpm *lpm);
 
+int rte_lpm_iter_init(struct rte_lpm_iter *iter, struct rte_lpm *lpm,
+		int order);
+
+int rte_lpm_iter_next(struct rte_lpm_iter *iter, struct rte_lpm_route *route);
+
+int rte_lpm_iter_bulk(struct rte_lpm_iter *iter, struct rte_lpm_route *routes,
+		unsigned int n);
+
+void rte_lpm_iter_fini(struct rte_lpm_iter *iter);
+
+int rte_lpm_rebuild(struct rte_lpm *lpm, unsigned int nb_threads);
+
+int rte_lpm_tbl8_compact(struct rte_lpm *lpm, uint32_t max_work);
+
+int rte_lpm_tbl8_reclaim(struct rte_lpm *lpm);
+
+void rte_lpm_free(struct rte_lpm *lpm);
+
+/*
+ * Shared memory lpm. The tables are laid out in one position independent
+ * block (tbl8 and rules are referenced by offset from the table base) so a
+ * single writer process can update them while other processes attach the
+ * same shm_open/memfd object read-only and call rte_lpm_lookup directly.
+ */
+struct rte_lpm *rte_lpm_create_fd(int fd, const char *name,
+		const struct rte_lpm_config *config);
+struct rte_lpm *rte_lpm_shm_create(const char *name,
+		const struct rte_lpm_config *config);
+struct rte_lpm *rte_lpm_attach_fd(int fd, int flags);
+struct rte_lpm *rte_lpm_shm_attach(const char *name, int flags);
+void rte_lpm_shm_detach(struct rte_lpm *lpm);
+int rte_lpm_shm_unlink(const char *name);
+
 #endif
 
@@ -0,0 +1,566 @@
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lpm.h"
+#include "lpm2d.h"
+
+/** Matrix cell value of a class pair that no rule matches. */
+#define LPM2D_NO_RULE                   UINT32_MAX
+
+/** Number of addresses looked up per rte_lpm_lookup_bulk() call. */
+#define LPM2D_BURST                     64
+
+/** @internal Distinct prefix of one field, the class id is its index + 1. */
+struct lpm2d_prefix {
+	uint32_t ip;
+	uint8_t depth;
+};
+
+/** @internal One field of the classifier. */
+struct lpm2d_field {
+	struct rte_lpm *lpm;    /**< Maps an address to its class id. */
+	uint32_t nb_classes;    /**< Classes, including the wildcard class 0. */
+	uint32_t nb_ids;        /**< Reduced class ids, the matrix dimension. */
+	struct lpm2d_prefix *prefixes; /**< Prefix of class id - 1. */
+	uint32_t *parent;       /**< Class of the longest enclosing prefix. */
+};
+
+/**
+ * @internal Set of distinct equal length vectors of a matrix, vector v
+ * starts at base[v * vec_stride] and has len elements elem_stride apart.
+ */
+struct lpm2d_vec_set {
+	const uint32_t *base;
+	uint32_t len;
+	size_t vec_stride;
+	size_t elem_stride;
+	uint32_t *slots;        /**< Hash table of id + 1, 0 if empty. */
+	uint32_t mask;
+	uint32_t *reps;         /**< First vector of every id. */
+	uint32_t nb_ids;
+};
+
+/** @internal lpm2d structure. */
+struct rte_lpm2d {
+	char name[RTE_LPM2D_NAMESIZE];  /**< Name of the lpm2d. */
+	uint32_t max_rules;     /**< Max. rules. */
+	uint32_t max_cells;     /**< Max. matrix cells. */
+	uint32_t nb_rules;      /**< Used rules so far. */
+	struct rte_lpm2d_rule *rules; /**< Rules, in insertion order. */
+
+	/* Built by rte_lpm2d_build(). */
+	struct lpm2d_field src;
+	struct lpm2d_field dst;
+	uint32_t *matrix;       /**< Result of every (src, dst) class pair. */
+};
+
+static inline uint32_t
+lpm2d_mask(uint8_t depth)
+{
+	return depth ? (uint32_t)(~0U << (RTE_LPM_MAX_DEPTH - depth)) : 0;
+}
+
+static int
+lpm2d_prefix_cmp(const void *a, const void *b)
+{
+	const struct lpm2d_prefix *x = a, *y = b;
+
+	if (x->depth != y->depth)
+		return x->depth < y->depth ? -1 : 1;
+	if (x->ip != y->ip)
+		return x->ip < y->ip ? -1 : 1;
+	return 0;
+}
+
+static void
+lpm2d_field_free(struct lpm2d_field *field)
+{
+	rte_lpm_free(field->lpm);
+	free(field->prefixes);
+	free(field->parent);
+	memset(field, 0, sizeof(*field));
+}
+
+/*
+ * Class id of a prefix of the field, 0 for the wildcard.
+ */
+static uint32_t
+lpm2d_class(const struct lpm2d_field *field, uint32_t ip, uint8_t depth)
+{
+	struct lpm2d_prefix key, *p;
+
+	if (depth == 0)
+		return 0;
+
+	key.ip = ip & lpm2d_mask(depth);
+	key.depth = depth;
+	p = bsearch(&key, field->prefixes, field->nb_classes - 1,
+			sizeof(key), lpm2d_prefix_cmp);
+
+	return (uint32_t)(p - field->prefixes) + 1;
+}
+
+/*
+ * (Re)creates the field lpm, mapping every prefix to ids[class], or to its
+ * class id when ids is NULL. Prefixes go in by increasing depth, so in the
+ * latter case looking a prefix up before adding it yields its parent class,
+ * which always has a smaller id than the prefix itself.
+ */
+static int
+lpm2d_field_lpm(struct rte_lpm2d *ctx, struct lpm2d_field *field,
+		const uint32_t *ids)
+{
+	struct rte_lpm_config config = {0};
+	uint32_t i, nb_tbl8 = 0, next_hop;
+	struct lpm2d_prefix *p;
+	int ret;
+
+	for (i = 1; i < field->nb_classes; i++)
+		if (field->prefixes[i - 1].depth > MAX_DEPTH_TBL24)
+			nb_tbl8++;
+
+	rte_lpm_free(field->lpm);
+	config.max_rules = field->nb_classes;
+	config.number_tbl8s = nb_tbl8;
+	field->lpm = rte_lpm_create(ctx->name, &config);
+	if (field->lpm == NULL)
+		return -ENOMEM;
+
+	for (i = 1; i < field->nb_classes; i++) {
+		p = &field->prefixes[i - 1];
+		if (ids == NULL &&
+				rte_lpm_lookup(field->lpm, p->ip, &next_hop) == 0)
+			field->parent[i] = next_hop;
+
+		ret = rte_lpm_add(field->lpm, p->ip, p->depth,
+				ids != NULL ? ids[i] : i);
+		if (ret < 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Collects the distinct prefixes of one field of the rules, installs them in
+ * the field lpm and records the parent of every class.
+ */
+static int
+lpm2d_field_build(struct rte_lpm2d *ctx, struct lpm2d_field *field, int dst)
+{
+	struct lpm2d_prefix *p;
+	uint32_t i, n = 0;
+
+	field->prefixes = malloc((ctx->nb_rules + 1) * sizeof(*field->prefixes));
+	if (field->prefixes == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < ctx->nb_rules; i++) {
+		p = &field->prefixes[n];
+		p->depth = dst ? ctx->rules[i].dst_depth : ctx->rules[i].src_depth;
+		p->ip = dst ? ctx->rules[i].dst_ip : ctx->rules[i].src_ip;
+		p->ip &= lpm2d_mask(p->depth);
+		if (p->depth != 0)
+			n++;
+	}
+
+	qsort(field->prefixes, n, sizeof(*field->prefixes), lpm2d_prefix_cmp);
+	for (i = 0, field->nb_classes = 1; i < n; i++) {
+		if (field->nb_classes > 1 && lpm2d_prefix_cmp(&field->prefixes[i],
+				&field->prefixes[field->nb_classes - 2]) == 0)
+			continue;
+		field->prefixes[field->nb_classes - 1] = field->prefixes[i];
+		field->nb_classes++;
+	}
+
+	field->parent = calloc(field->nb_classes, sizeof(uint32_t));
+	if (field->parent == NULL)
+		return -ENOMEM;
+
+	return lpm2d_field_lpm(ctx, field, NULL);
+}
+
+static int
+lpm2d_vec_set_init(struct lpm2d_vec_set *set, uint32_t max_vecs)
+{
+	uint32_t size = 1;
+
+	while (size < 2 * max_vecs)
+		size <<= 1;
+
+	set->slots = calloc(size, sizeof(uint32_t));
+	set->reps = malloc(max_vecs * sizeof(uint32_t));
+	set->mask = size - 1;
+	set->nb_ids = 0;
+	if (set->slots == NULL || set->reps == NULL) {
+		free(set->slots);
+		free(set->reps);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void
+lpm2d_vec_set_free(struct lpm2d_vec_set *set)
+{
+	free(set->slots);
+	free(set->reps);
+	set->slots = NULL;
+	set->reps = NULL;
+}
+
+/*
+ * Id of vector v: the id of an equal vector added before, or the next id,
+ * with v as its representative.
+ */
+static uint32_t
+lpm2d_vec_id(struct lpm2d_vec_set *set, uint32_t v)
+{
+	const uint32_t *a = &set->base[v * set->vec_stride], *b;
+	uint64_t hash = 14695981039346656037ULL; /* FNV-1a */
+	uint32_t i, slot, id;
+
+	for (i = 0; i < set->len; i++) {
+		hash ^= a[i * set->elem_stride];
+		hash *= 1099511628211ULL;
+	}
+
+	for (slot = (uint32_t)(hash ^ (hash >> 32)) & set->mask;
+			set->slots[slot] != 0; slot = (slot + 1) & set->mask) {
+		id = set->slots[slot] - 1;
+		b = &set->base[set->reps[id] * set->vec_stride];
+		for (i = 0; i < set->len; i++)
+			if (a[i * set->elem_stride] != b[i * set->elem_stride])
+				break;
+		if (i == set->len)
+			return id;
+	}
+
+	id = set->nb_ids++;
+	set->reps[id] = v;
+	set->slots[slot] = id + 1;
+
+	return id;
+}
+
+static inline uint32_t
+lpm2d_best(const struct rte_lpm2d *ctx, uint32_t a, uint32_t b)
+{
+	if (a == LPM2D_NO_RULE)
+		return b;
+	if (b == LPM2D_NO_RULE)
+		return a;
+	if (ctx->rules[a].priority != ctx->rules[b].priority)
+		return ctx->rules[a].priority < ctx->rules[b].priority ? a : b;
+	return a < b ? a : b;
+}
+
+/*
+ * Creates an empty classifier able to hold config->max_rules rules.
+ */
+struct rte_lpm2d *
+rte_lpm2d_create(const char *name, const struct rte_lpm2d_config *config)
+{
+	struct rte_lpm2d *ctx;
+
+	if ((name == NULL) || (config == NULL) || (config->max_rules == 0)) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	ctx->rules = calloc(config->max_rules, sizeof(*ctx->rules));
+	if (ctx->rules == NULL) {
+		free(ctx);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	strncpy(ctx->name, name, sizeof(ctx->name) - 1);
+	ctx->max_rules = config->max_rules;
+	ctx->max_cells = config->max_cells ? config->max_cells :
+			RTE_LPM2D_MAX_CELLS;
+
+	return ctx;
+}
+
+/*
+ * Queues a rule. Rules take effect on the next rte_lpm2d_build().
+ */
+int
+rte_lpm2d_add(struct rte_lpm2d *ctx, const struct rte_lpm2d_rule *rule)
+{
+	if ((ctx == NULL) || (rule == NULL) ||
+			(rule->src_depth > RTE_LPM_MAX_DEPTH) ||
+			(rule->dst_depth > RTE_LPM_MAX_DEPTH) ||
+			(rule->userdata > RTE_LPM_MAX_NH))
+		return -EINVAL;
+
+	if (ctx->nb_rules == ctx->max_rules)
+		return -ENOSPC;
+
+	ctx->rules[ctx->nb_rules++] = *rule;
+
+	return 0;
+}
+
+/*
+ * Fills one matrix row per distinct source class row, i.e. the source
+ * classes that match the same rule for every destination class share a row.
+ * The row of a source class is the row of its parent plus the cells of the
+ * rules of the class itself, then every destination class inherits the
+ * cell of its parent; parents have smaller ids, so increasing passes see
+ * final values. Only distinct rows are kept, src_ids maps every source
+ * class to its row.
+ */
+static int
+lpm2d_build_rows(struct rte_lpm2d *ctx, const struct lpm2d_field *src,
+		const struct lpm2d_field *dst, uint32_t *src_ids,
+		uint32_t **matrix, uint32_t *nb_rows)
+{
+	uint32_t *first = NULL, *order = NULL, *src_cls = NULL, *dst_cls = NULL;
+	uint32_t *rows = NULL, *row, *tmp;
+	uint32_t i, s, d, r, cap = 0, nb_dst = dst->nb_classes;
+	struct lpm2d_vec_set set = {0};
+	const struct rte_lpm2d_rule *rule;
+	int ret = -ENOMEM;
+
+	/* Rules bucketed by source class. */
+	first = calloc(src->nb_classes + 1, sizeof(uint32_t));
+	order = malloc((ctx->nb_rules + 1) * sizeof(uint32_t));
+	src_cls = malloc((ctx->nb_rules + 1) * sizeof(uint32_t));
+	dst_cls = malloc((ctx->nb_rules + 1) * sizeof(uint32_t));
+	if (first == NULL || order == NULL || src_cls == NULL ||
+			dst_cls == NULL ||
+			lpm2d_vec_set_init(&set, src->nb_classes) < 0)
+		goto out;
+
+	for (i = 0; i < ctx->nb_rules; i++) {
+		rule = &ctx->rules[i];
+		src_cls[i] = lpm2d_class(src, rule->src_ip, rule->src_depth);
+		dst_cls[i] = lpm2d_class(dst, rule->dst_ip, rule->dst_depth);
+		first[src_cls[i] + 1]++;
+	}
+	for (s = 0; s < src->nb_classes; s++)
+		first[s + 1] += first[s];
+	for (i = 0; i < ctx->nb_rules; i++)
+		order[first[src_cls[i]]++] = i;
+	/* Placing shifted every bucket start to the next one. */
+	for (s = src->nb_classes; s > 0; s--)
+		first[s] = first[s - 1];
+	first[0] = 0;
+
+	set.len = nb_dst;
+	set.vec_stride = nb_dst;
+	set.elem_stride = 1;
+
+	for (s = 0; s < src->nb_classes; s++) {
+		/* Room for the candidate row after the distinct ones. */
+		if (set.nb_ids == cap) {
+			if ((uint64_t)(set.nb_ids + 1) * nb_dst > ctx->max_cells) {
+				ret = -ENOSPC;
+				goto out;
+			}
+			cap = cap ? cap * 2 : 64;
+			if ((uint64_t)cap * nb_dst > ctx->max_cells)
+				cap = ctx->max_cells / nb_dst;
+			tmp = realloc(rows, (size_t)cap * nb_dst * sizeof(uint32_t));
+			if (tmp == NULL)
+				goto out;
+			rows = tmp;
+			set.base = rows;
+		}
+
+		row = &rows[(size_t)set.nb_ids * nb_dst];
+		if (s == 0)
+			memset(row, 0xff, nb_dst * sizeof(uint32_t));
+		else
+			memcpy(row, &rows[(size_t)src_ids[src->parent[s]] * nb_dst],
+				nb_dst * sizeof(uint32_t));
+
+		for (i = first[s]; i < first[s + 1]; i++) {
+			r = order[i];
+			row[dst_cls[r]] = lpm2d_best(ctx, row[dst_cls[r]], r);
+		}
+		for (d = 1; d < nb_dst; d++)
+			row[d] = lpm2d_best(ctx, row[d], row[dst->parent[d]]);
+
+		src_ids[s] = lpm2d_vec_id(&set, set.nb_ids);
+	}
+
+	*matrix = rows;
+	*nb_rows = set.nb_ids;
+	rows = NULL;
+	ret = 0;
+
+out:
+	lpm2d_vec_set_free(&set);
+	free(rows);
+	free(first);
+	free(order);
+	free(src_cls);
+	free(dst_cls);
+	return ret;
+}
+
+/*
+ * Builds the class tables and the class pair matrix from the rules added so
+ * far. The previous build keeps serving until the new one is complete, but
+ * the swap itself must not race with rte_lpm2d_classify_bulk().
+ *
+ * Classes are then reduced by result: destination classes whose matrix
+ * columns are equal share one id, and so do source classes with equal
+ * rows. The field lpms map addresses straight to the reduced ids, so the
+ * classify cost does not change.
+ */
+int
+rte_lpm2d_build(struct rte_lpm2d *ctx)
+{
+	struct lpm2d_field src = {0}, dst = {0};
+	struct lpm2d_vec_set set = {0};
+	uint32_t *matrix = NULL, *src_ids = NULL, *dst_ids = NULL;
+	uint32_t i, s, d, nb_rows, nb_dst;
+	int ret;
+
+	if (ctx == NULL)
+		return -EINVAL;
+
+	ret = lpm2d_field_build(ctx, &src, 0);
+	if (ret == 0)
+		ret = lpm2d_field_build(ctx, &dst, 1);
+	if (ret < 0)
+		goto fail;
+
+	src_ids = malloc(src.nb_classes * sizeof(uint32_t));
+	dst_ids = malloc(dst.nb_classes * sizeof(uint32_t));
+	if (src_ids == NULL || dst_ids == NULL) {
+		ret = -ENOMEM;
+		goto fail;
+	}
+
+	ret = lpm2d_build_rows(ctx, &src, &dst, src_ids, &matrix, &nb_rows);
+	if (ret < 0)
+		goto fail;
+	nb_dst = dst.nb_classes;
+
+	/* Store results in rte_lpm_lookup_bulk() format. */
+	for (i = 0; i < nb_rows * nb_dst; i++)
+		matrix[i] = (matrix[i] == LPM2D_NO_RULE) ? 0 :
+			(ctx->rules[matrix[i]].userdata | RTE_LPM_LOOKUP_SUCCESS);
+
+	/* Merge equal columns, then rows equal once columns are merged. */
+	ret = lpm2d_vec_set_init(&set, nb_dst);
+	if (ret < 0)
+		goto fail;
+	set.base = matrix;
+	set.len = nb_rows;
+	set.vec_stride = 1;
+	set.elem_stride = nb_dst;
+	for (d = 0; d < nb_dst; d++)
+		dst_ids[d] = lpm2d_vec_id(&set, d);
+	dst.nb_ids = set.nb_ids;
+	for (s = 0; s < nb_rows; s++)
+		for (d = 0; d < dst.nb_ids; d++)
+			matrix[s * dst.nb_ids + d] =
+				matrix[s * nb_dst + set.reps[d]];
+	lpm2d_vec_set_free(&set);
+
+	ret = lpm2d_vec_set_init(&set, nb_rows);
+	if (ret < 0)
+		goto fail;
+	set.base = matrix;
+	set.len = dst.nb_ids;
+	set.vec_stride = dst.nb_ids;
+	set.elem_stride = 1;
+	for (s = 0; s < src.nb_classes; s++)
+		src_ids[s] = lpm2d_vec_id(&set, src_ids[s]);
+	src.nb_ids = set.nb_ids;
+	for (s = 0; s < src.nb_ids; s++)
+		memmove(&matrix[s * dst.nb_ids],
+			&matrix[set.reps[s] * dst.nb_ids],
+			dst.nb_ids * sizeof(uint32_t));
+	lpm2d_vec_set_free(&set);
+
+	ret = lpm2d_field_lpm(ctx, &src, src_ids);
+	if (ret == 0)
+		ret = lpm2d_field_lpm(ctx, &dst, dst_ids);
+	if (ret < 0)
+		goto fail;
+	free(src_ids);
+	free(dst_ids);
+
+	lpm2d_field_free(&ctx->src);
+	lpm2d_field_free(&ctx->dst);
+	free(ctx->matrix);
+	ctx->src = src;
+	ctx->dst = dst;
+	ctx->matrix = matrix;
+
+	return 0;
+
+fail:
+	lpm2d_field_free(&src);
+	lpm2d_field_free(&dst);
+	free(src_ids);
+	free(dst_ids);
+	free(matrix);
+	return ret;
+}
+
+/*
+ * Classifies n (source, destination) address pairs. On a match results[i]
+ * holds the userdata of the best rule with RTE_LPM_LOOKUP_SUCCESS set,
+ * otherwise 0.
+ */
+int
+rte_lpm2d_classify_bulk(struct rte_lpm2d *ctx, const uint32_t *src_ips,
+		const uint32_t *dst_ips, uint32_t *results, unsigned int n)
+{
+	uint32_t src_cls[LPM2D_BURST], dst_cls[LPM2D_BURST];
+	uint32_t s, d, nb_dst;
+	unsigned int i, j, burst;
+
+	if ((ctx == NULL) || (ctx->matrix == NULL) || (src_ips == NULL) ||
+			(dst_ips == NULL) || (results == NULL))
+		return -EINVAL;
+
+	nb_dst = ctx->dst.nb_ids;
+	for (i = 0; i < n; i += burst) {
+		burst = (n - i < LPM2D_BURST) ? n - i : LPM2D_BURST;
+
+		rte_lpm_lookup_bulk(ctx->src.lpm, &src_ips[i], src_cls, burst);
+		rte_lpm_lookup_bulk(ctx->dst.lpm, &dst_ips[i], dst_cls, burst);
+
+		for (j = 0; j < burst; j++) {
+			s = (src_cls[j] & RTE_LPM_LOOKUP_SUCCESS) ?
+				(src_cls[j] & RTE_LPM_MAX_NH) : 0;
+			d = (dst_cls[j] & RTE_LPM_LOOKUP_SUCCESS) ?
+				(dst_cls[j] & RTE_LPM_MAX_NH) : 0;
+			results[i + j] = ctx->matrix[s * nb_dst + d];
+		}
+	}
+
+	return 0;
+}
+
+void
+rte_lpm2d_free(struct rte_lpm2d *ctx)
+{
+	if (ctx == NULL)
+		return;
+
+	lpm2d_field_free(&ctx->src);
+	lpm2d_field_free(&ctx->dst);
+	free(ctx->matrix);
+	free(ctx->rules);
+	free(ctx);
+}
@@ -0,0 +1,62 @@
+#ifndef _LPM2D_H_
+#define _LPM2D_H_
+
+#include <stdint.h>
+
+#include "lpm.h"
+
+/*
+ * Two field (source prefix, destination prefix) classifier built from two
+ * rte_lpm tables.
+ *
+ * Every distinct source prefix of the rule set is an equivalence class, and
+ * the source table maps an address to the class of its longest matching
+ * prefix; the destination side works the same way. rte_lpm2d_build()
+ * precomputes the best rule of every (source class, destination class) pair
+ * in a matrix, so classifying a packet costs two DIR-24-8 lookups and one
+ * matrix load. Classes that select the same results are merged before the
+ * matrix is stored, but the build still fills one 32 bit cell per pair of
+ * distinct source row and destination class: the number of distinct source
+ * prefixes times the number of distinct destination prefixes must stay
+ * within config.max_cells. With the default limit that allows about 4k
+ * rules whose prefixes are all distinct, and tens of thousands of rules
+ * when they share a few thousand prefixes per field.
+ */
+
+/** Max number of characters in an lpm2d name. */
+#define RTE_LPM2D_NAMESIZE              RTE_LPM_NAMESIZE
+
+/** Default limit on the number of matrix cells. */
+#define RTE_LPM2D_MAX_CELLS             (1 << 24)
+
+/** lpm2d configuration structure. */
+struct rte_lpm2d_config {
+	uint32_t max_rules;      /**< Max number of rules. */
+	uint32_t max_cells;      /**< Max matrix cells, 0 for the default. */
+};
+
+/** lpm2d rule. A zero depth matches any address. */
+struct rte_lpm2d_rule {
+	uint32_t src_ip;         /**< Source prefix. */
+	uint8_t src_depth;       /**< Source prefix length. */
+	uint8_t dst_depth;       /**< Destination prefix length. */
+	uint32_t dst_ip;         /**< Destination prefix. */
+	uint32_t priority;       /**< Lower values win, ties go to the oldest. */
+	uint32_t userdata;       /**< Result, up to RTE_LPM_MAX_NH. */
+};
+
+struct rte_lpm2d;
+
+struct rte_lpm2d *rte_lpm2d_create(const char *name,
+		const struct rte_lpm2d_config *config);
+
+int rte_lpm2d_add(struct rte_lpm2d *ctx, const struct rte_lpm2d_rule *rule);
+
+int rte_lpm2d_build(struct rte_lpm2d *ctx);
+
+int rte_lpm2d_classify_bulk(struct rte_lpm2d *ctx, const uint32_t *src_ips,
+		const uint32_t *dst_ips, uint32_t *results, unsigned int n);
+
+void rte_lpm2d_free(struct rte_lpm2d *ctx);
+
+#endif
@@ -0,0 +1,456 @@
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+
+#include "lpm.h"
+
+/*
+ * Route churn benchmark: reader threads run bulk lookups continuously while
+ * writer threads replay an add/delete stream against the same table.
+ *
+ *   lpm_perf [-r readers] [-w writers] [-n routes] [-u updates]
+ *            [-b burst] [-d seconds] [-m mutex|lockfree] [-f stream]
+ *
+ * In "mutex" mode readers take the table mutex around every bulk lookup,
+ * as lpm/main.c does; in "lockfree" mode only writers serialize on it.
+ * A stream file holds one update per line: "A a.b.c.d/len next_hop" or
+ * "D a.b.c.d/len". Without a file every writer toggles its own slice of
+ * a random prefix pool, alternating between add and delete.
+ *
+ * Writer 0 releases the tbl8 groups freed by deletes every
+ * RECLAIM_INTERVAL updates, after a grace period in lockfree mode.
+ */
+
+#define MAX_THREADS 64
+#define READER_IPS  (1 << 16)
+#define RECLAIM_INTERVAL 1024
+#define STREAM_POOL_BITS 12
+
+enum update_op {
+	OP_ADD,
+	OP_DEL,
+};
+
+struct update {
+	uint32_t ip;
+	uint8_t depth;
+	uint8_t op;
+	uint32_t next_hop;
+};
+
+struct reader_arg {
+	pthread_t thread;
+	uint32_t *ips;
+	uint64_t lookups;
+	volatile uint64_t quiescent;
+};
+
+struct writer_arg {
+	pthread_t thread;
+	const struct update *stream;
+	uint32_t nb_updates;
+	uint64_t *latency_ns;
+	uint32_t done;
+	double elapsed;
+};
+
+static struct rte_lpm *lpm_table;
+static pthread_mutex_t lpm_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct reader_arg readers[MAX_THREADS];
+static unsigned int nb_readers = 2;
+static int reader_lock;
+static unsigned int burst = 32;
+static volatile int stop;
+static volatile int start;
+static struct writer_arg writers[MAX_THREADS];
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t
+rand_ip(unsigned int *seed)
+{
+	return ((uint32_t)rand_r(seed) << 16) ^ (uint32_t)rand_r(seed);
+}
+
+static void *
+reader_loop(void *arg)
+{
+	struct reader_arg *r = arg;
+	uint32_t next_hops[256];
+	uint32_t pos = 0;
+
+	while (!start)
+		;
+
+	while (!stop) {
+		if (reader_lock)
+			pthread_mutex_lock(&lpm_mutex);
+		rte_lpm_lookup_bulk(lpm_table, &r->ips[pos], next_hops, burst);
+		if (reader_lock)
+			pthread_mutex_unlock(&lpm_mutex);
+
+		/* No lookup in flight: report a quiescent state. */
+		__atomic_store_n(&r->quiescent, r->quiescent + 1,
+				__ATOMIC_RELEASE);
+		r->lookups += burst;
+		pos = (pos + burst) & (READER_IPS - 1);
+		if (pos + burst > READER_IPS)
+			pos = 0;
+	}
+
+	return NULL;
+}
+
+/*
+ * Waits until every reader went through a quiescent state, i.e. none of
+ * them is still in a lookup that started before the call.
+ */
+static void
+wait_grace_period(void)
+{
+	uint64_t snap[MAX_THREADS];
+	unsigned int i;
+
+	for (i = 0; i < nb_readers; i++)
+		snap[i] = __atomic_load_n(&readers[i].quiescent,
+				__ATOMIC_ACQUIRE);
+	for (i = 0; i < nb_readers; i++) {
+		while (!stop && __atomic_load_n(&readers[i].quiescent,
+				__ATOMIC_ACQUIRE) == snap[i])
+			sched_yield();
+	}
+}
+
+static void *
+writer_loop(void *arg)
+{
+	struct writer_arg *w = arg;
+	const struct update *u;
+	uint64_t t0, begin;
+	uint32_t i;
+
+	while (!start)
+		;
+
+	begin = now_ns();
+	for (i = 0; i < w->nb_updates && !stop; i++) {
+		u = &w->stream[i];
+
+		/* Untimed; readers holding the mutex need no grace period. */
+		if (w == &writers[0] && i % RECLAIM_INTERVAL == 0 && i != 0) {
+			if (!reader_lock)
+				wait_grace_period();
+			pthread_mutex_lock(&lpm_mutex);
+			rte_lpm_tbl8_reclaim(lpm_table);
+			pthread_mutex_unlock(&lpm_mutex);
+		}
+
+		t0 = now_ns();
+		pthread_mutex_lock(&lpm_mutex);
+		if (u->op == OP_ADD)
+			rte_lpm_add(lpm_table, u->ip, u->depth, u->next_hop);
+		else
+			rte_lpm_delete(lpm_table, u->ip, u->depth);
+		pthread_mutex_unlock(&lpm_mutex);
+		w->latency_ns[i] = now_ns() - t0;
+	}
+	w->done = i;
+	w->elapsed = (now_ns() - begin) / 1e9;
+
+	return NULL;
+}
+
+static int
+parse_update(const char *line, struct update *u)
+{
+	char op, addr[32];
+	struct in_addr ip;
+	unsigned int depth, next_hop = 0;
+	int n;
+
+	n = sscanf(line, " %c %31[0-9.]/%u %u", &op, addr, &depth, &next_hop);
+	if (n < 3 || inet_aton(addr, &ip) == 0 || depth < 1 ||
+			depth > RTE_LPM_MAX_DEPTH)
+		return -EINVAL;
+
+	u->ip = ntohl(ip.s_addr);
+	u->depth = depth;
+	u->next_hop = next_hop;
+	if (op == 'A' || op == 'a')
+		u->op = OP_ADD;
+	else if (op == 'D' || op == 'd')
+		u->op = OP_DEL;
+	else
+		return -EINVAL;
+
+	return 0;
+}
+
+static struct update *
+load_stream(const char *path, uint32_t *nb_updates)
+{
+	struct update *stream = NULL, *tmp;
+	uint32_t n = 0, cap = 0;
+	char line[128];
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (f == NULL)
+		return NULL;
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (n == cap) {
+			cap = cap ? cap * 2 : 1024;
+			tmp = realloc(stream, cap * sizeof(*stream));
+			if (tmp == NULL) {
+				free(stream);
+				fclose(f);
+				return NULL;
+			}
+			stream = tmp;
+		}
+		if (parse_update(line, &stream[n]) == 0)
+			n++;
+	}
+
+	fclose(f);
+	*nb_updates = n;
+	return stream;
+}
+
+/*
+ * Every writer toggles the routes of its own prefix pool, so the stream
+ * never adds an installed route or deletes a missing one. Stream routes
+ * are /25../32 and always go through tbl8 groups. The top bits of every
+ * address hold the writer id, then the pool slot, both within the /25
+ * mask, so routes of different slots or writers never collide.
+ */
+static struct update *
+gen_stream(uint32_t nb_updates, uint32_t writer, unsigned int seed)
+{
+	const uint32_t pool = 1 << STREAM_POOL_BITS;
+	struct update *stream, *slot;
+	uint32_t i, k;
+
+	stream = malloc(nb_updates * sizeof(*stream));
+	slot = calloc(pool, sizeof(*slot));
+	if (stream == NULL || slot == NULL) {
+		free(stream);
+		free(slot);
+		return NULL;
+	}
+
+	for (i = 0; i < nb_updates; i++) {
+		k = rand_r(&seed) % pool;
+		if (slot[k].op == OP_ADD) {
+			/* Slot is empty or was deleted: add a fresh route. */
+			slot[k].ip = (writer << 26) |
+				(k << (26 - STREAM_POOL_BITS)) |
+				(rand_ip(&seed) &
+				 ((1u << (26 - STREAM_POOL_BITS)) - 1));
+			slot[k].depth = 25 + rand_r(&seed) % 8;
+			slot[k].next_hop = k & RTE_LPM_MAX_NH;
+			stream[i] = slot[k];
+			slot[k].op = OP_DEL;
+		} else {
+			stream[i] = slot[k];
+			slot[k].op = OP_ADD;
+		}
+	}
+
+	free(slot);
+	return stream;
+}
+
+static int
+cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int
+usage(const char *prog)
+{
+	printf("usage: %s [-r readers] [-w writers] [-n routes] "
+		"[-u updates] [-b burst] [-d seconds] "
+		"[-m mutex|lockfree] [-f stream]\n", prog);
+	return -1;
+}
+
+int main(int argc, char *argv[])
+{
+	struct rte_lpm_config config = {0};
+	unsigned int nb_writers = 1, duration = 5;
+	uint32_t nb_routes = 100000, nb_updates = 100000;
+	struct update *file_stream = NULL;
+	uint32_t file_updates = 0;
+	unsigned int seed = 1;
+	uint64_t *latency, total_lookups = 0, total_updates = 0;
+	double elapsed, writer_time = 0;
+	uint32_t i, j, n;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:w:n:u:b:d:m:f:")) != -1) {
+		switch (opt) {
+		case 'r':
+			nb_readers = atoi(optarg);
+			break;
+		case 'w':
+			nb_writers = atoi(optarg);
+			break;
+		case 'n':
+			nb_routes = atoi(optarg);
+			break;
+		case 'u':
+			nb_updates = atoi(optarg);
+			break;
+		case 'b':
+			burst = atoi(optarg);
+			break;
+		case 'd':
+			duration = atoi(optarg);
+			break;
+		case 'm':
+			if (strcmp(optarg, "mutex") == 0)
+				reader_lock = 1;
+			else if (strcmp(optarg, "lockfree") == 0)
+				reader_lock = 0;
+			else
+				return usage(argv[0]);
+			break;
+		case 'f':
+			file_stream = load_stream(optarg, &file_updates);
+			if (file_stream == NULL) {
+				printf("Cannot load update stream %s\n", optarg);
+				return -1;
+			}
+			break;
+		default:
+			return usage(argv[0]);
+		}
+	}
+
+	if (nb_readers > MAX_THREADS || nb_writers == 0 ||
+			nb_writers > MAX_THREADS || burst == 0 || burst > 256) {
+		printf("Invalid thread count or burst size\n");
+		return -1;
+	}
+
+	config.max_rules = nb_routes + nb_updates * nb_writers + 1;
+	config.number_tbl8s = 1 << 16;
+	lpm_table = rte_lpm_create("LPM_perf", &config);
+	if (lpm_table == NULL) {
+		printf("Cannot create LPM table\n");
+		return -1;
+	}
+
+	/* Preload the table with distinct /24 routes. */
+	for (i = 0; i < nb_routes; i++)
+		rte_lpm_add(lpm_table, ((i * 2654435761u) & 0xFFFFFF) << 8, 24,
+				i & RTE_LPM_MAX_NH);
+
+	for (i = 0; i < nb_readers; i++) {
+		readers[i].ips = malloc(READER_IPS * sizeof(uint32_t));
+		if (readers[i].ips == NULL)
+			return -1;
+		for (j = 0; j < READER_IPS; j++)
+			readers[i].ips[j] = rand_ip(&seed);
+		readers[i].lookups = 0;
+		readers[i].quiescent = 0;
+		if (pthread_create(&readers[i].thread, NULL, reader_loop,
+				&readers[i]) != 0) {
+			printf("Cannot create reader %u, running %u\n", i, i);
+			nb_readers = i;
+			break;
+		}
+	}
+
+	for (i = 0; i < nb_writers; i++) {
+		if (file_stream != NULL) {
+			/* Writers replay consecutive slices of the file. */
+			n = file_updates / nb_writers;
+			writers[i].stream = &file_stream[i * n];
+			writers[i].nb_updates = n;
+		} else {
+			writers[i].stream = gen_stream(nb_updates, i, seed + i);
+			writers[i].nb_updates = nb_updates;
+		}
+		writers[i].latency_ns = calloc(writers[i].nb_updates + 1,
+				sizeof(uint64_t));
+		if (writers[i].stream == NULL || writers[i].latency_ns == NULL)
+			return -1;
+		if (pthread_create(&writers[i].thread, NULL, writer_loop,
+				&writers[i]) != 0) {
+			printf("Cannot create writer %u, running %u\n", i, i);
+			nb_writers = i;
+			break;
+		}
+	}
+
+	if (nb_writers == 0) {
+		stop = 1;
+		start = 1;
+		for (i = 0; i < nb_readers; i++)
+			pthread_join(readers[i].thread, NULL);
+		return -1;
+	}
+
+	elapsed = now_ns() / 1e9;
+	start = 1;
+	sleep(duration);
+	stop = 1;
+	elapsed = now_ns() / 1e9 - elapsed;
+
+	for (i = 0; i < nb_readers; i++) {
+		pthread_join(readers[i].thread, NULL);
+		total_lookups += readers[i].lookups;
+	}
+	for (i = 0; i < nb_writers; i++) {
+		pthread_join(writers[i].thread, NULL);
+		total_updates += writers[i].done;
+		if (writers[i].elapsed > writer_time)
+			writer_time = writers[i].elapsed;
+	}
+
+	latency = malloc((total_updates + 1) * sizeof(uint64_t));
+	if (latency == NULL)
+		return -1;
+	for (i = 0, n = 0; i < nb_writers; i++) {
+		memcpy(&latency[n], writers[i].latency_ns,
+			writers[i].done * sizeof(uint64_t));
+		n += writers[i].done;
+	}
+	qsort(latency, n, sizeof(uint64_t), cmp_u64);
+
+	printf("mode:%s readers:%u writers:%u burst:%u routes:%u\n",
+		reader_lock ? "mutex" : "lockfree", nb_readers, nb_writers,
+		burst, nb_routes);
+	printf("reader: %.2f Mlookups/s\n", total_lookups / elapsed / 1e6);
+	printf("writer: %.0f updates/s (%lu updates)\n",
+		writer_time > 0 ? total_updates / writer_time : 0.0,
+		(unsigned long)total_updates);
+	if (n > 0)
+		printf("update latency ns: p50:%lu p99:%lu p99.9:%lu max:%lu\n",
+			(unsigned long)latency[n / 2],
+			(unsigned long)latency[(uint64_t)n * 99 / 100],
+			(unsigned long)latency[(uint64_t)n * 999 / 1000],
+			(unsigned long)latency[n - 1]);
+
+	return 0;
+}
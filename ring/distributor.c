@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#include "distributor.h"
+
+/* Fibonacci hashing, the top bits of tag * 2^32/phi select the bucket. */
+#define DIST_HASH_MULT  0x9e3779b1u
+#define DIST_HASH_SHIFT (32 - __builtin_ctz(RTE_DIST_BUCKETS))
+
+/*
+ * Bucket and current worker of every object of a pass. The AVX2 version
+ * hashes eight tags per iteration and gathers their workers from the
+ * bucket table.
+ */
+static void
+__rte_dist_steer_scalar(const struct rte_dist_obj *objs, unsigned int n,
+		const uint32_t *table, uint32_t *buckets, uint32_t *workers)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		buckets[i] = (objs[i].tag * DIST_HASH_MULT) >> DIST_HASH_SHIFT;
+		workers[i] = table[buckets[i]];
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2"))) static void
+__rte_dist_steer_avx2(const struct rte_dist_obj *objs, unsigned int n,
+		const uint32_t *table, uint32_t *buckets, uint32_t *workers)
+{
+	/* tags sit every sizeof(struct rte_dist_obj) / 4 words */
+	const int stride = sizeof(struct rte_dist_obj) / sizeof(uint32_t);
+	const __m256i vidx = _mm256_setr_epi32(0, stride, 2 * stride,
+			3 * stride, 4 * stride, 5 * stride, 6 * stride,
+			7 * stride);
+	const __m256i mult = _mm256_set1_epi32((int)DIST_HASH_MULT);
+	__m256i tag, bkt, wrk;
+	unsigned int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		tag = _mm256_i32gather_epi32((const int *)&objs[i].tag, vidx,
+				4);
+		bkt = _mm256_srli_epi32(_mm256_mullo_epi32(tag, mult),
+				DIST_HASH_SHIFT);
+		wrk = _mm256_i32gather_epi32((const int *)table, bkt, 4);
+		_mm256_storeu_si256((__m256i *)&buckets[i], bkt);
+		_mm256_storeu_si256((__m256i *)&workers[i], wrk);
+	}
+	if (i < n)
+		__rte_dist_steer_scalar(&objs[i], n - i, table, &buckets[i],
+				&workers[i]);
+}
+
+#endif
+
+static void (*__rte_dist_steer)(const struct rte_dist_obj *objs,
+		unsigned int n, const uint32_t *table, uint32_t *buckets,
+		uint32_t *workers) = __rte_dist_steer_scalar;
+
+static void __attribute__((constructor))
+__rte_dist_steer_select(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		__rte_dist_steer = __rte_dist_steer_avx2;
+#endif
+}
+
+
+/* worker with the most free space, used when a bucket has to move */
+static unsigned int
+__rte_dist_least_loaded(const struct rte_distributor *d,
+		const unsigned int *space)
+{
+	unsigned int w, best = 0;
+
+	for (w = 1; w < d->nb_workers; w++)
+		if (space[w] > space[best])
+			best = w;
+	return best;
+}
+
+static unsigned int
+__rte_dist_process_burst(struct rte_distributor *d,
+		struct rte_dist_obj *objs, unsigned int n)
+{
+	uint32_t buckets[RTE_DIST_BURST], workers[RTE_DIST_BURST];
+	unsigned int space[RTE_DIST_MAX_WORKERS];
+	unsigned int staged[RTE_DIST_MAX_WORKERS];
+	unsigned int i, w, nw, b, moved = 0;
+
+	/* only this thread enqueues, so free space can only grow meanwhile */
+	for (w = 0; w < d->nb_workers; w++) {
+		space[w] = rte_ring_free_count(d->worker_rings[w]);
+		staged[w] = 0;
+	}
+
+	__rte_dist_steer(objs, n, d->bucket_worker, buckets, workers);
+
+	for (i = 0; i < n; i++) {
+		b = buckets[i];
+		/* a bucket moved in this pass makes the gathered workers stale */
+		w = moved ? d->bucket_worker[b] : workers[i];
+
+		if (unlikely(rte_ring_get_capacity(d->worker_rings[w]) -
+				space[w] >= d->high_water) &&
+				d->bucket_inflight[b] == 0) {
+			nw = __rte_dist_least_loaded(d, space);
+			if (space[nw] > space[w]) {
+				d->bucket_worker[b] = nw;
+				w = nw;
+				moved = 1;
+			}
+		}
+
+		if (space[w] == 0)
+			break;
+
+		objs[i].bucket = b;
+		d->stage[w][staged[w]++] = objs[i];
+		space[w]--;
+		d->bucket_inflight[b]++;
+	}
+
+	for (w = 0; w < d->nb_workers; w++)
+		if (staged[w] != 0)
+			rte_ring_sp_enqueue_bulk_elem(d->worker_rings[w],
+					d->stage[w], sizeof(struct rte_dist_obj),
+					staged[w], NULL);
+
+	return i;
+}
+
+unsigned int
+rte_distributor_process(struct rte_distributor *d, struct rte_dist_obj *objs,
+		unsigned int n)
+{
+	unsigned int done = 0, burst, ret;
+
+	while (done < n) {
+		burst = n - done < RTE_DIST_BURST ? n - done : RTE_DIST_BURST;
+		ret = __rte_dist_process_burst(d, &objs[done], burst);
+		done += ret;
+		if (ret < burst)
+			break;
+	}
+	return done;
+}
+
+unsigned int
+rte_distributor_returned(struct rte_distributor *d, struct rte_dist_obj *objs,
+		unsigned int n)
+{
+	unsigned int i;
+
+	n = rte_ring_sc_dequeue_burst_elem(d->ret_ring, objs,
+			sizeof(struct rte_dist_obj), n, NULL);
+	for (i = 0; i < n; i++)
+		d->bucket_inflight[objs[i].bucket & (RTE_DIST_BUCKETS - 1)]--;
+	return n;
+}
+
+unsigned int
+rte_distributor_get(struct rte_distributor *d, unsigned int worker,
+		struct rte_dist_obj *objs, unsigned int n)
+{
+	return rte_ring_sc_dequeue_burst_elem(d->worker_rings[worker], objs,
+			sizeof(struct rte_dist_obj), n, NULL);
+}
+
+unsigned int
+rte_distributor_return(struct rte_distributor *d,
+		const struct rte_dist_obj *objs, unsigned int n)
+{
+	return rte_ring_mp_enqueue_burst_elem(d->ret_ring, objs,
+			sizeof(struct rte_dist_obj), n, NULL);
+}
+
+
+struct rte_distributor *
+rte_distributor_create(unsigned int nb_workers, unsigned int ring_size)
+{
+	struct rte_distributor *d;
+	void *mem_ptr = NULL;
+	unsigned int w;
+
+	if (nb_workers == 0 || nb_workers > RTE_DIST_MAX_WORKERS ||
+			!POWEROF2(ring_size) || ring_size < 2) {
+		printf("Invalid number of workers or ring size\n");
+		return NULL;
+	}
+
+	if (posix_memalign(&mem_ptr, RTE_CACHE_LINE_SIZE, sizeof(*d)) != 0) {
+		printf("Cannot reserve memory\n");
+		return NULL;
+	}
+	d = mem_ptr;
+	memset(d, 0, sizeof(*d));
+	d->nb_workers = nb_workers;
+
+	d->ret_ring = rte_ring_create_elem(sizeof(struct rte_dist_obj),
+			rte_align32pow2(ring_size * nb_workers), RING_F_SC_DEQ);
+	if (d->ret_ring == NULL)
+		goto fail;
+	for (w = 0; w < nb_workers; w++) {
+		d->worker_rings[w] = rte_ring_create_elem(
+				sizeof(struct rte_dist_obj), ring_size,
+				RING_F_SP_ENQ | RING_F_SC_DEQ);
+		if (d->worker_rings[w] == NULL)
+			goto fail;
+	}
+	d->high_water = rte_ring_get_capacity(d->worker_rings[0]) * 3 / 4;
+
+	/* start with the buckets spread round robin */
+	for (w = 0; w < RTE_DIST_BUCKETS; w++)
+		d->bucket_worker[w] = w % nb_workers;
+
+	return d;
+
+fail:
+	rte_distributor_free(d);
+	return NULL;
+}
+
+void
+rte_distributor_free(struct rte_distributor *d)
+{
+	unsigned int w;
+
+	if (d == NULL)
+		return;
+	for (w = 0; w < d->nb_workers; w++)
+		rte_ring_free(d->worker_rings[w]);
+	rte_ring_free(d->ret_ring);
+	free(d);
+}
@@ -0,0 +1,70 @@
+#ifndef DISTRIBUTOR_H_
+#define DISTRIBUTOR_H_
+#include <stdint.h>
+
+#include "ring.h"
+
+/*
+ * Flow affinity distributor: one thread takes bursts of (flow tag, object)
+ * pairs and fans them out to N workers, each through its own SP/SC ring,
+ * so that all objects of a flow go to the same worker in order. Workers
+ * hand every object back through a shared MP/SC return ring.
+ *
+ * Tags are hashed into RTE_DIST_BUCKETS buckets and every bucket is mapped
+ * to a worker. A bucket only moves to another worker when its worker has
+ * backed up (its ring is at least 3/4 full) and no object of the bucket is
+ * in flight, i.e. all of them came back through the return ring, so moving
+ * it cannot reorder a flow. Workers must therefore return every object
+ * they get, with its bucket field unchanged.
+ */
+
+#define RTE_DIST_MAX_WORKERS 64
+#define RTE_DIST_BUCKETS 1024           /**< power of 2 */
+#define RTE_DIST_BURST 64               /**< objects steered per pass */
+
+/** Ring element, 16 bytes on 64-bit targets. */
+struct rte_dist_obj {
+	uint32_t tag;     /**< flow tag, e.g. the RSS hash */
+	uint32_t bucket;  /**< set by rte_distributor_process() */
+	void *obj;        /**< user object */
+};
+
+struct rte_distributor {
+	unsigned int nb_workers;
+	unsigned int high_water;        /**< worker ring count that backs up */
+	struct rte_ring *ret_ring;      /**< workers -> distributor */
+	struct rte_ring *worker_rings[RTE_DIST_MAX_WORKERS];
+
+	uint32_t bucket_worker[RTE_DIST_BUCKETS];   /**< bucket -> worker */
+	uint32_t bucket_inflight[RTE_DIST_BUCKETS]; /**< handed out, not back */
+
+	/** per worker staging of one pass, flushed with one bulk enqueue */
+	struct rte_dist_obj stage[RTE_DIST_MAX_WORKERS][RTE_DIST_BURST];
+};
+
+/*
+ * ring_size is the size of every worker ring and must be a power of 2; the
+ * return ring holds nb_workers times as many objects.
+ */
+struct rte_distributor *rte_distributor_create(unsigned int nb_workers,
+		unsigned int ring_size);
+void rte_distributor_free(struct rte_distributor *d);
+
+/*
+ * Distributor side, one thread only. process() steers objs[0..n-1] and
+ * returns how many were taken: it stops at the first object whose worker
+ * ring is full, the caller keeps objs[ret..n-1] and retries them later.
+ * returned() collects up to n objects handed back by the workers.
+ */
+unsigned int rte_distributor_process(struct rte_distributor *d,
+		struct rte_dist_obj *objs, unsigned int n);
+unsigned int rte_distributor_returned(struct rte_distributor *d,
+		struct rte_dist_obj *objs, unsigned int n);
+
+/* Worker side: burst get from the worker ring, burst return. */
+unsigned int rte_distributor_get(struct rte_distributor *d,
+		unsigned int worker, struct rte_dist_obj *objs, unsigned int n);
+unsigned int rte_distributor_return(struct rte_distributor *d,
+		const struct rte_dist_obj *objs, unsigned int n);
+
+#endif
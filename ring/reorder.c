@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "reorder.h"
+
+static uint64_t
+__rte_reorder_clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline void *
+__rte_reorder_slot(const struct rte_reorder_buffer *b, uint32_t idx)
+{
+	return b->slots + (size_t)idx * b->esize;
+}
+
+/* move the window head one slot on, returning its object if any */
+static inline int
+__rte_reorder_advance(struct rte_reorder_buffer *b, void *obj)
+{
+	int valid = b->valid[b->head];
+
+	if (valid) {
+		if (obj != NULL)
+			memcpy(obj, __rte_reorder_slot(b, b->head), b->esize);
+		b->valid[b->head] = 0;
+		b->order_count--;
+	}
+	b->head = (b->head + 1) & b->mask;
+	b->min_seqn++;
+	return valid;
+}
+
+/* push the window forward by shift slots, its objects go to the ready ring */
+static int
+__rte_reorder_shift(struct rte_reorder_buffer *b, uint32_t shift)
+{
+	void *slot;
+
+	/* checked up front so the window never moves halfway */
+	if (rte_ring_free_count(b->ready) < b->order_count)
+		return -ENOSPC;
+
+	while (shift != 0 && b->order_count != 0) {
+		slot = __rte_reorder_slot(b, b->head);
+		if (b->valid[b->head])
+			rte_ring_sp_enqueue_bulk_elem(b->ready, slot, b->esize,
+					1, NULL);
+		__rte_reorder_advance(b, NULL);
+		shift--;
+	}
+
+	/* the window is empty, jump straight to the new position */
+	b->min_seqn += shift;
+	b->head = (b->head + shift) & b->mask;
+	b->gap_start = 0;
+	return 0;
+}
+
+int
+rte_reorder_insert(struct rte_reorder_buffer *b, const void *obj)
+{
+	uint32_t seqn, offset, idx;
+	int ret;
+
+	memcpy(&seqn, (const uint8_t *)obj + b->seqn_offset, sizeof(seqn));
+
+	if (unlikely(!b->started)) {
+		b->min_seqn = seqn;
+		b->started = 1;
+	}
+
+	/* modulo 2^32, a late seqn gives a negative offset */
+	offset = seqn - b->min_seqn;
+	if ((int32_t)offset < 0)
+		return -ERANGE;
+
+	if (offset >= b->size) {
+		ret = __rte_reorder_shift(b, offset - b->size + 1);
+		if (ret != 0)
+			return ret;
+		offset = b->size - 1;
+	}
+
+	idx = (b->head + offset) & b->mask;
+	if (b->valid[idx])
+		return -EEXIST;
+
+	memcpy(__rte_reorder_slot(b, idx), obj, b->esize);
+	b->valid[idx] = 1;
+	b->order_count++;
+	return 0;
+}
+
+unsigned int
+rte_reorder_drain(struct rte_reorder_buffer *b, void *obj_table,
+		unsigned int n)
+{
+	uint8_t *obj = obj_table;
+	unsigned int nb;
+	uint64_t now;
+
+	nb = rte_ring_sc_dequeue_burst_elem(b->ready, obj_table, b->esize, n,
+			NULL);
+
+	while (nb < n && b->order_count != 0) {
+		if (b->valid[b->head]) {
+			__rte_reorder_advance(b, obj + (size_t)nb * b->esize);
+			nb++;
+			b->gap_start = 0;
+			continue;
+		}
+
+		if (b->timeout_ns == 0)
+			break;
+
+		/* a gap with later objects behind it: wait, then skip it */
+		now = __rte_reorder_clock_ns();
+		if (b->gap_start == 0) {
+			b->gap_start = now;
+			break;
+		}
+		if (now - b->gap_start < b->timeout_ns)
+			break;
+		while (!b->valid[b->head])
+			__rte_reorder_advance(b, NULL);
+		b->gap_start = 0;
+	}
+
+	return nb;
+}
+
+
+void
+rte_reorder_min_seqn_set(struct rte_reorder_buffer *b, uint32_t seqn)
+{
+	b->min_seqn = seqn;
+	b->started = 1;
+}
+
+
+ssize_t
+rte_reorder_get_memsize(unsigned int esize, unsigned int count)
+{
+	ssize_t sz, ring_sz;
+
+	/* the ready ring also checks esize */
+	if (!POWEROF2(count) || count < 2 || count > RTE_RING_SZ_MASK / 2) {
+		printf("Requested number of elements is invalid, must be power of 2, and not exceed %u\n",
+			RTE_RING_SZ_MASK / 2);
+		return -EINVAL;
+	}
+	ring_sz = rte_ring_get_memsize_elem(esize, count * 2);
+	if (ring_sz < 0)
+		return ring_sz;
+
+	sz = sizeof(struct rte_reorder_buffer) + (ssize_t)count * esize + count;
+	sz = RTE_ALIGN(sz, RTE_CACHE_LINE_SIZE);
+	return sz + ring_sz;
+}
+
+
+struct rte_reorder_buffer *
+rte_reorder_create(unsigned int esize, unsigned int count,
+		unsigned int seqn_offset, uint64_t timeout_ns)
+{
+	struct rte_reorder_buffer *b;
+	void *mem_ptr = NULL;
+	ssize_t size;
+
+	if (seqn_offset + sizeof(uint32_t) > esize) {
+		printf("Sequence number does not fit in the element\n");
+		return NULL;
+	}
+
+	size = rte_reorder_get_memsize(esize, count);
+	if (size < 0)
+		return NULL;
+
+	if (posix_memalign(&mem_ptr, RTE_CACHE_LINE_SIZE, size) != 0) {
+		printf("Cannot reserve memory\n");
+		return NULL;
+	}
+
+	b = mem_ptr;
+	memset(b, 0, sizeof(*b));
+	b->size = count;
+	b->mask = count - 1;
+	b->esize = esize;
+	b->seqn_offset = seqn_offset;
+	b->timeout_ns = timeout_ns;
+	b->slots = (uint8_t *)&b[1];
+	b->valid = b->slots + (size_t)count * esize;
+	b->ready = (struct rte_ring *)((uint8_t *)b +
+			RTE_ALIGN(sizeof(*b) + (size_t)count * esize + count,
+				RTE_CACHE_LINE_SIZE));
+
+	/* capacity 2 * count - 1, more than a full window */
+	if (rte_ring_init(b->ready, count * 2,
+			RING_F_SP_ENQ | RING_F_SC_DEQ) != 0) {
+		free(mem_ptr);
+		return NULL;
+	}
+
+	rte_reorder_reset(b);
+	return b;
+}
+
+void
+rte_reorder_reset(struct rte_reorder_buffer *b)
+{
+	memset(b->valid, 0, b->size);
+	b->min_seqn = 0;
+	b->head = 0;
+	b->order_count = 0;
+	b->started = 0;
+	b->gap_start = 0;
+	rte_ring_init(b->ready, b->size * 2, RING_F_SP_ENQ | RING_F_SC_DEQ);
+}
+
+/* free the reorder buffer */
+void
+rte_reorder_free(struct rte_reorder_buffer *b)
+{
+	free(b);
+}
@@ -0,0 +1,68 @@
+#ifndef REORDER_H_
+#define REORDER_H_
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "ring.h"
+
+/*
+ * Reorder buffer: puts objects that carry a 32-bit sequence number back in
+ * sequence order, e.g. after a burst was spread over several workers.
+ *
+ * Objects are copied by value, esize bytes each, with the same storage
+ * rules as rte_ring_create_elem(): esize a multiple of 4 and count a power
+ * of 2. The sequence number is the uint32_t at seqn_offset in the object.
+ *
+ * The order window holds count slots for the sequence numbers from the
+ * next expected one (min_seqn) on. Objects that fall out of the window
+ * because a later one pushed it forward, gaps and all, wait in the ready
+ * ring. Drain hands out the ready ring first, then every in-order object
+ * at the head of the window. A gap at the head blocks drain until it is
+ * filled or, with a non-zero timeout, until it has been seen for
+ * timeout_ns, after which drain skips it. Everything lives in the one
+ * allocation made at create time.
+ */
+
+struct rte_reorder_buffer {
+	uint32_t size;           /**< Size of the order window. */
+	uint32_t mask;           /**< Mask (size-1) of the window. */
+	uint32_t esize;          /**< Object size in bytes. */
+	uint32_t seqn_offset;    /**< Offset of the seqn in an object. */
+	uint64_t timeout_ns;     /**< Gap timeout, 0 to wait forever. */
+
+	uint32_t min_seqn;       /**< seqn of the window head */
+	uint32_t head;           /**< window slot of min_seqn */
+	uint32_t order_count;    /**< objects in the window */
+	int started;             /**< min_seqn set */
+	uint64_t gap_start;      /**< when drain first saw the head gap */
+
+	uint8_t *slots;          /**< size objects */
+	uint8_t *valid;          /**< size flags, slot holds an object */
+	struct rte_ring *ready;  /**< objects pushed out of the window */
+} __rte_cache_aligned;
+
+ssize_t rte_reorder_get_memsize(unsigned int esize, unsigned int count);
+struct rte_reorder_buffer *rte_reorder_create(unsigned int esize,
+		unsigned int count, unsigned int seqn_offset,
+		uint64_t timeout_ns);
+void rte_reorder_reset(struct rte_reorder_buffer *b);
+void rte_reorder_free(struct rte_reorder_buffer *b);
+
+/*
+ * Next sequence number to hand out; by default the seqn of the first
+ * object inserted after create or reset.
+ */
+void rte_reorder_min_seqn_set(struct rte_reorder_buffer *b, uint32_t seqn);
+
+/*
+ * Copy obj into the buffer. Returns 0, -ERANGE if its seqn was already
+ * drained or skipped, -EEXIST if that seqn is already held, or -ENOSPC if
+ * the window would have to move but the ready ring has no room.
+ */
+int rte_reorder_insert(struct rte_reorder_buffer *b, const void *obj);
+
+/* Copy up to n objects in sequence order to obj_table, return how many. */
+unsigned int rte_reorder_drain(struct rte_reorder_buffer *b, void *obj_table,
+		unsigned int n);
+
+#endif
@@ -5,6 +5,11 @@
 #include <inttypes.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 #include "ring.h"
 
@@ -39,8 +44,10 @@ static int
 get_sync_type(uint32_t flags, enum rte_ring_sync_type *prod_st,
 	enum rte_ring_sync_type *cons_st)
 {
-	static const uint32_t prod_st_flags =RING_F_SP_ENQ;
-	static const uint32_t cons_st_flags =RING_F_SC_DEQ;
+	static const uint32_t prod_st_flags =RING_F_SP_ENQ | RING_F_MP_RTS_ENQ |
+		RING_F_MP_HTS_ENQ;
+	static const uint32_t cons_st_flags =RING_F_SC_DEQ | RING_F_MC_RTS_DEQ |
+		RING_F_MC_HTS_DEQ;
 
 	switch (flags & prod_st_flags) {
 	case 0:
@@ -49,6 +56,12 @@ get_sync_type(uint32_t flags, enum rte_ring_sync_type *prod_st,
 	case RING_F_SP_ENQ:
 		*prod_st = RTE_RING_SYNC_ST;
 		break;
+	case RING_F_MP_RTS_ENQ:
+		*prod_st = RTE_RING_SYNC_MT_RTS;
+		break;
+	case RING_F_MP_HTS_ENQ:
+		*prod_st = RTE_RING_SYNC_MT_HTS;
+		break;
 
 	default:
 		return -EINVAL;
@@ -61,6 +74,12 @@ get_sync_type(uint32_t flags, enum rte_ring_sync_type *prod_st,
 	case RING_F_SC_DEQ:
 		*cons_st = RTE_RING_SYNC_ST;
 		break;
+	case RING_F_MC_RTS_DEQ:
+		*cons_st = RTE_RING_SYNC_MT_RTS;
+		break;
+	case RING_F_MC_HTS_DEQ:
+		*cons_st = RTE_RING_SYNC_MT_HTS;
+		break;
 	default:
 		return -EINVAL;
 	}
@@ -102,6 +121,12 @@ rte_ring_init(struct rte_ring *r, unsigned int count, unsigned int flags)
 		r->capacity = r->mask;
 	}
 
+	/* set default values for head-tail distance */
+	if (flags & RING_F_MP_RTS_ENQ)
+		rte_ring_set_prod_htd_max(r, r->capacity / 8);
+	if (flags & RING_F_MC_RTS_DEQ)
+		rte_ring_set_cons_htd_max(r, r->capacity / 8);
+
 	return 0;
 }
 
@@ -113,7 +138,6 @@ rte_ring_create_elem(unsigned int esize, unsigned int count, unsigned int flags)
 	void*  mem_ptr = NULL;
 	ssize_t ring_size;
 	const unsigned int requested_count = count;
-	int ret;
 
 
 	/* for an exact size ring, round up from count to a power of two */
@@ -125,12 +149,16 @@ rte_ring_create_elem(unsigned int esize, unsigned int count, unsigned int flags)
 		return NULL;
 	}
 
-	mem_ptr = malloc(ring_size);
+	/* keep the prod/cons cache lines of the header on their own lines */
+	if (posix_memalign(&mem_ptr, RTE_CACHE_LINE_SIZE, ring_size) != 0)
+		mem_ptr = NULL;
 	if (mem_ptr != NULL) {
 		r = mem_ptr;
-		/* no need to check return value here, we already checked the
-		 * arguments above */
-		rte_ring_init(r, requested_count, flags);
+		/* the size was checked above, the flags are checked here */
+		if (rte_ring_init(r, requested_count, flags) != 0) {
+			free(mem_ptr);
+			r = NULL;
+		}
 
 	} else {
 		r = NULL;
@@ -149,10 +177,124 @@ rte_ring_create(unsigned int count, unsigned int flags)
 }
 
 
+/*
+ * Statistics, see struct rte_ring_stats. The hooks compile to nothing
+ * without RTE_RING_STATS.
+ */
+#ifdef RTE_RING_STATS
+
+static __thread unsigned int __rte_ring_stats_tid;
+static unsigned int __rte_ring_stats_nb_tids;
+
+static inline struct rte_ring_stats *
+__rte_ring_stats(struct rte_ring *r)
+{
+	if (unlikely(__rte_ring_stats_tid == 0))
+		__rte_ring_stats_tid = __atomic_add_fetch(
+				&__rte_ring_stats_nb_tids, 1, __ATOMIC_RELAXED);
+	return &r->stats[(__rte_ring_stats_tid - 1) % RTE_RING_STATS_SLOTS].s;
+}
+
+#define __RTE_RING_STAT_ADD(r, name, v) (__rte_ring_stats(r)->name += (v))
+
+/* n objects reserved from head on, or nothing if n == 0 */
+static inline void
+__rte_ring_stat_enq(struct rte_ring *r, uint32_t head, unsigned int n)
+{
+	struct rte_ring_stats *st = __rte_ring_stats(r);
+	uint32_t used, wm;
+
+	if (n == 0) {
+		st->enq_fail_bulk++;
+		return;
+	}
+	st->enq_success_bulk++;
+	st->enq_success_objs += n;
+
+	/* the watermark line is only written when the maximum grows */
+	used = head + n - __atomic_load_n(&r->cons.tail, __ATOMIC_RELAXED);
+	wm = __atomic_load_n(&r->watermark, __ATOMIC_RELAXED);
+	while (unlikely(used > wm) &&
+			!__atomic_compare_exchange_n(&r->watermark, &wm, used,
+				1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+}
+
+static inline void
+__rte_ring_stat_deq(struct rte_ring *r, unsigned int n)
+{
+	struct rte_ring_stats *st = __rte_ring_stats(r);
+
+	if (n == 0) {
+		st->deq_fail_bulk++;
+		return;
+	}
+	st->deq_success_bulk++;
+	st->deq_success_objs += n;
+}
+
+#else
+
+#define __RTE_RING_STAT_ADD(r, name, v) do { (void)(r); (void)(v); } while (0)
+
+static inline void
+__rte_ring_stat_enq(struct rte_ring *r, uint32_t head, unsigned int n)
+{
+	(void)r;
+	(void)head;
+	(void)n;
+}
+
+static inline void
+__rte_ring_stat_deq(struct rte_ring *r, unsigned int n)
+{
+	(void)r;
+	(void)n;
+}
+
+#endif /* RTE_RING_STATS */
+
+
+
+#ifdef RTE_USE_C11_MEM_MODEL
+
+/*
+ * C11 memory model version of the MP/MC head/tail protocol: the ordering
+ * comes from acquire loads of the other side's tail and release stores of
+ * our own tail, instead of volatile accesses and full barriers.
+ */
+static  void update_tail(struct rte_ring_headtail *ht, uint32_t old_val, uint32_t new_val,
+		uint32_t single, uint32_t enqueue)
+{
+	(void)enqueue;
+
+	/*
+	 * If there are other enqueues/dequeues in progress that preceded us,
+	 * we need to wait for them to complete
+	 */
+	if (!single)
+		while (unlikely(__atomic_load_n(&ht->tail, __ATOMIC_RELAXED) !=
+				old_val))
+			rte_pause();
+
+	/* the copies to/from the ring happen before the new tail is seen */
+	__atomic_store_n(&ht->tail, new_val, __ATOMIC_RELEASE);
+}
+
+#else
 
 static  void update_tail(struct rte_ring_headtail *ht, uint32_t old_val, uint32_t new_val,
 		uint32_t single, uint32_t enqueue)
 {
+	/*
+	 * Objects copied in (enqueue) or out (dequeue) must be complete
+	 * before the tail move makes the slots visible to the other side.
+	 */
+	if (enqueue)
+		rte_smp_wmb();
+	else
+		rte_smp_rmb();
+
 	if (!single)
 		while (unlikely(ht->tail != old_val))
 			rte_pause();
@@ -160,6 +302,159 @@ static  void update_tail(struct rte_ring_headtail *ht, uint32_t old_val, uint32_
 	ht->tail = new_val;
 }
 
+#endif /* RTE_USE_C11_MEM_MODEL */
+
+
+/*
+ * Copy kernels for elements that are a multiple of 16 bytes. 16B elements
+ * use SSE2 moves inline; wider ones go through a block copy picked at
+ * load time from the CPU features (AVX-512: one 64B move per iteration,
+ * AVX2: 32B, otherwise 16B).
+ */
+#ifdef __SSE2__
+
+static inline void
+__rte_ring_copy_16(void *dst, const void *src)
+{
+	_mm_storeu_si128((__m128i *)dst, _mm_loadu_si128((const __m128i *)src));
+}
+
+#else
+
+static inline void
+__rte_ring_copy_16(void *dst, const void *src)
+{
+	memcpy(dst, src, 16);
+}
+
+#endif
+
+/* len is a multiple of 16 for all block copies */
+static void
+__rte_ring_copy_blk_16(void *dst, const void *src, size_t len)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	size_t i;
+
+	for (i = 0; i + 64 <= len; i += 64) {
+		__rte_ring_copy_16(d + i, s + i);
+		__rte_ring_copy_16(d + i + 16, s + i + 16);
+		__rte_ring_copy_16(d + i + 32, s + i + 32);
+		__rte_ring_copy_16(d + i + 48, s + i + 48);
+	}
+	for (; i < len; i += 16)
+		__rte_ring_copy_16(d + i, s + i);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2"))) static void
+__rte_ring_copy_blk_32(void *dst, const void *src, size_t len)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	size_t i;
+
+	for (i = 0; i + 32 <= len; i += 32)
+		_mm256_storeu_si256((__m256i *)(d + i),
+				_mm256_loadu_si256((const __m256i *)(s + i)));
+	if (i < len)
+		_mm_storeu_si128((__m128i *)(d + i),
+				_mm_loadu_si128((const __m128i *)(s + i)));
+}
+
+__attribute__((target("avx512f"))) static void
+__rte_ring_copy_blk_64(void *dst, const void *src, size_t len)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	size_t i;
+
+	for (i = 0; i + 64 <= len; i += 64)
+		_mm512_storeu_si512(d + i, _mm512_loadu_si512(s + i));
+	if (i + 32 <= len) {
+		_mm256_storeu_si256((__m256i *)(d + i),
+				_mm256_loadu_si256((const __m256i *)(s + i)));
+		i += 32;
+	}
+	if (i < len)
+		_mm_storeu_si128((__m128i *)(d + i),
+				_mm_loadu_si128((const __m128i *)(s + i)));
+}
+
+#endif
+
+static void (*__rte_ring_copy_blk)(void *dst, const void *src, size_t len) =
+		__rte_ring_copy_blk_16;
+
+static void __attribute__((constructor))
+__rte_ring_copy_select(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		__rte_ring_copy_blk = __rte_ring_copy_blk_64;
+	else if (__builtin_cpu_supports("avx2"))
+		__rte_ring_copy_blk = __rte_ring_copy_blk_32;
+#endif
+}
+
+
+static void __rte_ring_enqueue_elems_128(struct rte_ring *r, uint32_t prod_head,
+		const void *obj_table, uint32_t n)
+{
+	unsigned int i;
+	const uint32_t size = r->size;
+	uint32_t idx = prod_head & r->mask;
+	uint8_t *ring = (uint8_t *)&r[1];
+	const uint8_t *obj = (const uint8_t *)obj_table;
+	if (likely(idx + n <= size)) {
+		for (i = 0; i < (n & ~0x1); i += 2, idx += 2) {
+			__rte_ring_copy_16(ring + ((size_t)idx << 4),
+					obj + ((size_t)i << 4));
+			__rte_ring_copy_16(ring + ((size_t)idx << 4) + 16,
+					obj + ((size_t)i << 4) + 16);
+		}
+		if (n & 0x1)
+			__rte_ring_copy_16(ring + ((size_t)idx << 4),
+					obj + ((size_t)i << 4));
+	} else {
+		for (i = 0; idx < size; i++, idx++)
+			__rte_ring_copy_16(ring + ((size_t)idx << 4),
+					obj + ((size_t)i << 4));
+		/* Start at the beginning */
+		for (idx = 0; i < n; i++, idx++)
+			__rte_ring_copy_16(ring + ((size_t)idx << 4),
+					obj + ((size_t)i << 4));
+	}
+}
+
+
+/* esize is a multiple of 16: at most two contiguous block copies */
+static void __rte_ring_enqueue_elems_wide(struct rte_ring *r,
+		uint32_t prod_head, const void *obj_table, uint32_t esize,
+		uint32_t n)
+{
+	const uint32_t size = r->size;
+	uint32_t idx = prod_head & r->mask;
+	uint8_t *ring = (uint8_t *)&r[1];
+	const uint8_t *obj = (const uint8_t *)obj_table;
+	uint32_t first;
+
+	if (likely(idx + n <= size)) {
+		__rte_ring_copy_blk(ring + (size_t)idx * esize, obj,
+				(size_t)n * esize);
+	} else {
+		first = size - idx;
+		__rte_ring_copy_blk(ring + (size_t)idx * esize, obj,
+				(size_t)first * esize);
+		/* Start at the beginning */
+		__rte_ring_copy_blk(ring, obj + (size_t)first * esize,
+				(size_t)(n - first) * esize);
+	}
+}
+
 
 static void __rte_ring_enqueue_elems_64(struct rte_ring *r, uint32_t prod_head,
 		const void *obj_table, uint32_t n)
@@ -250,6 +545,10 @@ __rte_ring_enqueue_elems(struct rte_ring *r, uint32_t prod_head,
 	 */
 	if (esize == 8)
 		__rte_ring_enqueue_elems_64(r, prod_head, obj_table, num);
+	else if (esize == 16)
+		__rte_ring_enqueue_elems_128(r, prod_head, obj_table, num);
+	else if ((esize & 15) == 0)
+		__rte_ring_enqueue_elems_wide(r, prod_head, obj_table, esize, num);
 	else {
 		uint32_t idx, scale, nr_idx, nr_num, nr_size;
 
@@ -265,13 +564,95 @@ __rte_ring_enqueue_elems(struct rte_ring *r, uint32_t prod_head,
 }
 
 
+#ifdef RTE_USE_C11_MEM_MODEL
+
 static  unsigned int
 __rte_ring_move_prod_head(struct rte_ring *r, unsigned int is_sp,
 		unsigned int n, enum rte_ring_queue_behavior behavior,
 		uint32_t *old_head, uint32_t *new_head,
-		uint32_t *free_entries)
+		uint32_t *free_entries, int exact)
+{
+	const uint32_t capacity = r->capacity;
+	uint32_t cons_tail;
+	unsigned int max = n;
+	int success;
+
+	*old_head = __atomic_load_n(&r->prod.head, __ATOMIC_RELAXED);
+	do {
+		/* Reset n to the initial burst count */
+		n = max;
+
+		/* Ensure the head is read before tail */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		/*
+		 * load-acquire synchronize with store-release of ht->tail
+		 * in update_tail.
+		 */
+		if (is_sp) {
+			/*
+			 * A cache that trails the head by more than capacity
+			 * was left behind by multi-producer calls: the free
+			 * count computed from it wraps and must not be used.
+			 */
+			cons_tail = r->prod.cache_tail;
+			if (exact || *old_head - cons_tail > capacity ||
+					n > capacity + cons_tail - *old_head) {
+				cons_tail = __atomic_load_n(&r->cons.tail,
+						__ATOMIC_ACQUIRE);
+				r->prod.cache_tail = cons_tail;
+			}
+		} else {
+			cons_tail = __atomic_load_n(&r->cons.tail,
+					__ATOMIC_ACQUIRE);
+			/* Keep the cache fresh for later SP calls. */
+			__atomic_store_n(&r->prod.cache_tail, cons_tail,
+					__ATOMIC_RELAXED);
+		}
+
+		/*
+		 *  The subtraction is done between two unsigned 32bits value
+		 * (the result is always modulo 32 bits even if we have
+		 * *old_head > cons_tail). So 'free_entries' is always between 0
+		 * and capacity (which is < size).
+		 */
+		*free_entries = (capacity + cons_tail - *old_head);
+
+		/* check that we have enough room in ring */
+		if (unlikely(n > *free_entries))
+			n = (behavior == RTE_RING_QUEUE_FIXED) ?
+					0 : *free_entries;
+
+		if (n == 0)
+			return 0;
+
+		*new_head = *old_head + n;
+		if (is_sp) {
+			r->prod.head = *new_head;
+			success = 1;
+		} else {
+			/* on failure, *old_head is updated */
+			success = __atomic_compare_exchange_n(&r->prod.head,
+					old_head, *new_head,
+					0, __ATOMIC_RELAXED,
+					__ATOMIC_RELAXED);
+		}
+		if (unlikely(success == 0))
+			__RTE_RING_STAT_ADD(r, enq_cas_retries, 1);
+	} while (unlikely(success == 0));
+	return n;
+}
+
+#else
+
+static  unsigned int
+__rte_ring_move_prod_head(struct rte_ring *r, unsigned int is_sp,
+		unsigned int n, enum rte_ring_queue_behavior behavior,
+		uint32_t *old_head, uint32_t *new_head,
+		uint32_t *free_entries, int exact)
 {
 	const uint32_t capacity = r->capacity;
+	uint32_t cons_tail;
 	unsigned int max = n;
 	int success;
 
@@ -281,14 +662,30 @@ __rte_ring_move_prod_head(struct rte_ring *r, unsigned int is_sp,
 
 		*old_head = r->prod.head;
 
+		/* Read the head before the consumer tail. */
+		rte_smp_rmb();
+
 		/*
 		 *  The subtraction is done between two unsigned 32bits value
 		 * (the result is always modulo 32 bits even if we have
 		 * *old_head > cons_tail). So 'free_entries' is always between 0
 		 * and capacity (which is < size).
 		 */
-		*free_entries = (capacity + r->cons.tail - *old_head);
-		printf("r->cons.tail:%d,  r->prod.head:%d\n",  r->cons.tail, r->prod.head);
+		if (is_sp) {
+			/* A cache trailing by more than capacity is stale. */
+			cons_tail = r->prod.cache_tail;
+			if (exact || *old_head - cons_tail > capacity ||
+					n > capacity + cons_tail - *old_head) {
+				cons_tail = r->cons.tail;
+				r->prod.cache_tail = cons_tail;
+			}
+		} else {
+			/* Keep the cache fresh for later SP calls. */
+			cons_tail = r->cons.tail;
+			r->prod.cache_tail = cons_tail;
+		}
+		*free_entries = (capacity + cons_tail - *old_head);
+
 		/* check that we have enough room in ring */
 		if (unlikely(n > *free_entries))
 			n = (behavior == RTE_RING_QUEUE_FIXED) ?
@@ -303,10 +700,39 @@ __rte_ring_move_prod_head(struct rte_ring *r, unsigned int is_sp,
 		else
 			success = rte_atomic32_cmpset(&r->prod.head,
 					*old_head, *new_head);
+		if (unlikely(success == 0))
+			__RTE_RING_STAT_ADD(r, enq_cas_retries, 1);
 	} while (unlikely(success == 0));
 	return n;
 }
 
+#endif /* RTE_USE_C11_MEM_MODEL */
+
+static inline long
+__rte_ring_futex(volatile uint32_t *uaddr, int op, uint32_t val,
+		const struct timespec *timeout)
+{
+	return syscall(SYS_futex, (uint32_t *)(uintptr_t)uaddr, op, val,
+			timeout, NULL, 0);
+}
+
+/*
+ * Called after the producer tail moved by n. The fence pairs with the one
+ * in __rte_ring_dequeue_sleep: either the sleeper sees the new tail or we
+ * see the sleeper, so no wakeup is lost.
+ */
+static inline void
+__rte_ring_wake_consumers(struct rte_ring *r, unsigned int n)
+{
+	if (likely((r->flags & RING_F_DEQ_WAIT) == 0))
+		return;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&r->deq_waiters, __ATOMIC_RELAXED) != 0)
+		__rte_ring_futex(&r->prod.tail, FUTEX_WAKE,
+				n < INT_MAX ? n : INT_MAX, NULL);
+}
+
 
 static  unsigned int
 __rte_ring_do_enqueue_elem(struct rte_ring *r, const void *obj_table,
@@ -318,13 +744,16 @@ __rte_ring_do_enqueue_elem(struct rte_ring *r, const void *obj_table,
 	uint32_t free_entries;
 
 	n = __rte_ring_move_prod_head(r, is_sp, n, behavior,
-			&prod_head, &prod_next, &free_entries);
+			&prod_head, &prod_next, &free_entries,
+			free_space != NULL);
+	__rte_ring_stat_enq(r, prod_head, n);
 	if (n == 0)
 		goto end;
 
 	__rte_ring_enqueue_elems(r, prod_head, obj_table, esize, n);
 
 	update_tail(&r->prod, prod_head, prod_next, is_sp, 1);
+	__rte_ring_wake_consumers(r, n);
 end:
 	if (free_space != NULL)
 		*free_space = free_entries - n;
@@ -333,7 +762,7 @@ end:
 
 
 
-static  unsigned int
+unsigned int
 rte_ring_mp_enqueue_bulk_elem(struct rte_ring *r, const void *obj_table,
 		unsigned int esize, unsigned int n, unsigned int *free_space)
 {
@@ -342,7 +771,7 @@ rte_ring_mp_enqueue_bulk_elem(struct rte_ring *r, const void *obj_table,
 }
 
 
-static  unsigned int
+unsigned int
 rte_ring_sp_enqueue_bulk_elem(struct rte_ring *r, const void *obj_table,
 		unsigned int esize, unsigned int n, unsigned int *free_space)
 {
@@ -351,7 +780,7 @@ rte_ring_sp_enqueue_bulk_elem(struct rte_ring *r, const void *obj_table,
 }
 
 
-static  unsigned int
+unsigned int
 rte_ring_enqueue_bulk_elem(struct rte_ring *r, const void *obj_table,
 		unsigned int esize, unsigned int n, unsigned int *free_space)
 {
@@ -362,13 +791,115 @@ rte_ring_enqueue_bulk_elem(struct rte_ring *r, const void *obj_table,
 	case RTE_RING_SYNC_ST:
 		return rte_ring_sp_enqueue_bulk_elem(r, obj_table, esize, n,
 			free_space);
+	case RTE_RING_SYNC_MT_RTS:
+		return rte_ring_mp_rts_enqueue_bulk_elem(r, obj_table, esize, n,
+			free_space);
+	case RTE_RING_SYNC_MT_HTS:
+		return rte_ring_mp_hts_enqueue_bulk_elem(r, obj_table, esize, n,
+			free_space);
+	}
+
+	return 0;
+}
+
+
+unsigned int
+rte_ring_mp_enqueue_burst_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *free_space)
+{
+	return __rte_ring_do_enqueue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, RTE_RING_SYNC_MT, free_space);
+}
+
+
+unsigned int
+rte_ring_sp_enqueue_burst_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *free_space)
+{
+	return __rte_ring_do_enqueue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, RTE_RING_SYNC_ST, free_space);
+}
+
+
+unsigned int
+rte_ring_enqueue_burst_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *free_space)
+{
+	switch (r->prod.sync_type) {
+	case RTE_RING_SYNC_MT:
+		return rte_ring_mp_enqueue_burst_elem(r, obj_table, esize, n,
+			free_space);
+	case RTE_RING_SYNC_ST:
+		return rte_ring_sp_enqueue_burst_elem(r, obj_table, esize, n,
+			free_space);
+	case RTE_RING_SYNC_MT_RTS:
+		return rte_ring_mp_rts_enqueue_burst_elem(r, obj_table, esize,
+			n, free_space);
+	case RTE_RING_SYNC_MT_HTS:
+		return rte_ring_mp_hts_enqueue_burst_elem(r, obj_table, esize,
+			n, free_space);
 	}
 
 	return 0;
 }
 
 
-static  int
+/* pointer rings, esize == sizeof(void *) */
+unsigned int
+rte_ring_mp_enqueue_bulk(struct rte_ring *r, void * const *obj_table,
+		unsigned int n, unsigned int *free_space)
+{
+	return rte_ring_mp_enqueue_bulk_elem(r, obj_table, sizeof(void *),
+			n, free_space);
+}
+
+
+unsigned int
+rte_ring_sp_enqueue_bulk(struct rte_ring *r, void * const *obj_table,
+		unsigned int n, unsigned int *free_space)
+{
+	return rte_ring_sp_enqueue_bulk_elem(r, obj_table, sizeof(void *),
+			n, free_space);
+}
+
+
+unsigned int
+rte_ring_enqueue_bulk(struct rte_ring *r, void * const *obj_table,
+		unsigned int n, unsigned int *free_space)
+{
+	return rte_ring_enqueue_bulk_elem(r, obj_table, sizeof(void *),
+			n, free_space);
+}
+
+
+unsigned int
+rte_ring_mp_enqueue_burst(struct rte_ring *r, void * const *obj_table,
+		unsigned int n, unsigned int *free_space)
+{
+	return rte_ring_mp_enqueue_burst_elem(r, obj_table, sizeof(void *),
+			n, free_space);
+}
+
+
+unsigned int
+rte_ring_sp_enqueue_burst(struct rte_ring *r, void * const *obj_table,
+		unsigned int n, unsigned int *free_space)
+{
+	return rte_ring_sp_enqueue_burst_elem(r, obj_table, sizeof(void *),
+			n, free_space);
+}
+
+
+unsigned int
+rte_ring_enqueue_burst(struct rte_ring *r, void * const *obj_table,
+		unsigned int n, unsigned int *free_space)
+{
+	return rte_ring_enqueue_burst_elem(r, obj_table, sizeof(void *),
+			n, free_space);
+}
+
+
+int
 rte_ring_enqueue_elem(struct rte_ring *r, void *obj, unsigned int esize)
 {
 	return rte_ring_enqueue_bulk_elem(r, obj, esize, 1, NULL) ? 0 :
@@ -459,6 +990,61 @@ __rte_ring_dequeue_elems_32(struct rte_ring *r, const uint32_t size,
 }
 
 
+static  void
+__rte_ring_dequeue_elems_128(struct rte_ring *r, uint32_t cons_head,
+		void *obj_table, uint32_t n)
+{
+	unsigned int i;
+	const uint32_t size = r->size;
+	uint32_t idx = cons_head & r->mask;
+	const uint8_t *ring = (const uint8_t *)&r[1];
+	uint8_t *obj = (uint8_t *)obj_table;
+	if (likely(idx + n <= size)) {
+		for (i = 0; i < (n & ~0x1); i += 2, idx += 2) {
+			__rte_ring_copy_16(obj + ((size_t)i << 4),
+					ring + ((size_t)idx << 4));
+			__rte_ring_copy_16(obj + ((size_t)i << 4) + 16,
+					ring + ((size_t)idx << 4) + 16);
+		}
+		if (n & 0x1)
+			__rte_ring_copy_16(obj + ((size_t)i << 4),
+					ring + ((size_t)idx << 4));
+	} else {
+		for (i = 0; idx < size; i++, idx++)
+			__rte_ring_copy_16(obj + ((size_t)i << 4),
+					ring + ((size_t)idx << 4));
+		/* Start at the beginning */
+		for (idx = 0; i < n; i++, idx++)
+			__rte_ring_copy_16(obj + ((size_t)i << 4),
+					ring + ((size_t)idx << 4));
+	}
+}
+
+
+static  void
+__rte_ring_dequeue_elems_wide(struct rte_ring *r, uint32_t cons_head,
+		void *obj_table, uint32_t esize, uint32_t n)
+{
+	const uint32_t size = r->size;
+	uint32_t idx = cons_head & r->mask;
+	const uint8_t *ring = (const uint8_t *)&r[1];
+	uint8_t *obj = (uint8_t *)obj_table;
+	uint32_t first;
+
+	if (likely(idx + n <= size)) {
+		__rte_ring_copy_blk(obj, ring + (size_t)idx * esize,
+				(size_t)n * esize);
+	} else {
+		first = size - idx;
+		__rte_ring_copy_blk(obj, ring + (size_t)idx * esize,
+				(size_t)first * esize);
+		/* Start at the beginning */
+		__rte_ring_copy_blk(obj + (size_t)first * esize, ring,
+				(size_t)(n - first) * esize);
+	}
+}
+
+
 /* the actual dequeue of elements from the ring.
  * Placed here since identical code needed in both
  * single and multi producer enqueue functions.
@@ -472,6 +1058,10 @@ __rte_ring_dequeue_elems(struct rte_ring *r, uint32_t cons_head,
 	 */
 	if (esize == 8)
 		__rte_ring_dequeue_elems_64(r, cons_head, obj_table, num);
+	else if (esize == 16)
+		__rte_ring_dequeue_elems_128(r, cons_head, obj_table, num);
+	else if ((esize & 15) == 0)
+		__rte_ring_dequeue_elems_wide(r, cons_head, obj_table, esize, num);
 	else {
 		uint32_t idx, scale, nr_idx, nr_num, nr_size;
 
@@ -486,28 +1076,57 @@ __rte_ring_dequeue_elems(struct rte_ring *r, uint32_t cons_head,
 	}
 }
 
+#ifdef RTE_USE_C11_MEM_MODEL
+
 static  unsigned int
 __rte_ring_move_cons_head(struct rte_ring *r, unsigned int is_sc,
 		unsigned int n, enum rte_ring_queue_behavior behavior,
 		uint32_t *old_head, uint32_t *new_head,
-		uint32_t *entries)
+		uint32_t *entries, int exact)
 {
 	unsigned int max = n;
+	uint32_t prod_tail;
 	int success;
 
 	/* move cons.head atomically */
+	*old_head = __atomic_load_n(&r->cons.head, __ATOMIC_RELAXED);
 	do {
 		/* Restore n as it may change every loop */
 		n = max;
 
-		*old_head = r->cons.head;
+		/* Ensure the head is read before tail */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		/* this load-acquire synchronize with store-release of ht->tail
+		 * in update_tail.
+		 */
+		if (is_sc) {
+			/*
+			 * A cache behind the head was left by multi-consumer
+			 * calls: the entry count computed from it wraps and
+			 * must not be used.
+			 */
+			prod_tail = r->cons.cache_tail;
+			if (exact || prod_tail - *old_head > r->capacity ||
+					n > prod_tail - *old_head) {
+				prod_tail = __atomic_load_n(&r->prod.tail,
+						__ATOMIC_ACQUIRE);
+				r->cons.cache_tail = prod_tail;
+			}
+		} else {
+			prod_tail = __atomic_load_n(&r->prod.tail,
+					__ATOMIC_ACQUIRE);
+			/* Keep the cache fresh for later SC calls. */
+			__atomic_store_n(&r->cons.cache_tail, prod_tail,
+					__ATOMIC_RELAXED);
+		}
 
 		/* The subtraction is done between two unsigned 32bits value
 		 * (the result is always modulo 32 bits even if we have
 		 * cons_head > prod_tail). So 'entries' is always between 0
 		 * and size(ring)-1.
 		 */
-		*entries = (r->prod.tail - *old_head);
+		*entries = (prod_tail - *old_head);
 
 		/* Set the actual entries for dequeue */
 		if (n > *entries)
@@ -521,13 +1140,83 @@ __rte_ring_move_cons_head(struct rte_ring *r, unsigned int is_sc,
 			r->cons.head = *new_head;
 			success = 1;
 		} else {
-			success = rte_atomic32_cmpset(&r->cons.head, *old_head,
+			/* on failure, *old_head will be updated */
+			success = __atomic_compare_exchange_n(&r->cons.head,
+					old_head, *new_head,
+					0, __ATOMIC_RELAXED,
+					__ATOMIC_RELAXED);
+		}
+		if (unlikely(success == 0))
+			__RTE_RING_STAT_ADD(r, deq_cas_retries, 1);
+	} while (unlikely(success == 0));
+	return n;
+}
+
+#else
+
+static  unsigned int
+__rte_ring_move_cons_head(struct rte_ring *r, unsigned int is_sc,
+		unsigned int n, enum rte_ring_queue_behavior behavior,
+		uint32_t *old_head, uint32_t *new_head,
+		uint32_t *entries, int exact)
+{
+	unsigned int max = n;
+	uint32_t prod_tail;
+	int success;
+
+	/* move cons.head atomically */
+	do {
+		/* Restore n as it may change every loop */
+		n = max;
+
+		*old_head = r->cons.head;
+
+		/* Read the head before the producer tail, as in the enqueue. */
+		rte_smp_rmb();
+
+		/* The subtraction is done between two unsigned 32bits value
+		 * (the result is always modulo 32 bits even if we have
+		 * cons_head > prod_tail). So 'entries' is always between 0
+		 * and size(ring)-1.
+		 */
+		if (is_sc) {
+			/* A cache behind the head is stale. */
+			prod_tail = r->cons.cache_tail;
+			if (exact || prod_tail - *old_head > r->capacity ||
+					n > prod_tail - *old_head) {
+				prod_tail = r->prod.tail;
+				r->cons.cache_tail = prod_tail;
+			}
+		} else {
+			/* Keep the cache fresh for later SC calls. */
+			prod_tail = r->prod.tail;
+			r->cons.cache_tail = prod_tail;
+		}
+		*entries = (prod_tail - *old_head);
+
+		/* Set the actual entries for dequeue */
+		if (n > *entries)
+			n = (behavior == RTE_RING_QUEUE_FIXED) ? 0 : *entries;
+
+		if (unlikely(n == 0))
+			return 0;
+
+		*new_head = *old_head + n;
+		if (is_sc) {
+			r->cons.head = *new_head;
+			success = 1;
+		} else {
+			success = rte_atomic32_cmpset(&r->cons.head, *old_head,
 					*new_head);
 		}
+		if (unlikely(success == 0))
+			__RTE_RING_STAT_ADD(r, deq_cas_retries, 1);
 	} while (unlikely(success == 0));
 	return n;
 }
 
+#endif /* RTE_USE_C11_MEM_MODEL */
+
 
 
 static  unsigned int
@@ -540,7 +1229,8 @@ __rte_ring_do_dequeue_elem(struct rte_ring *r, void *obj_table,
 	uint32_t entries;
 
 	n = __rte_ring_move_cons_head(r, (int)is_sc, n, behavior,
-			&cons_head, &cons_next, &entries);
+			&cons_head, &cons_next, &entries, available != NULL);
+	__rte_ring_stat_deq(r, n);
 	if (n == 0)
 		goto end;
 
@@ -555,7 +1245,7 @@ end:
 }
 
 
-static  unsigned int
+unsigned int
 rte_ring_sc_dequeue_bulk_elem(struct rte_ring *r, void *obj_table,
 		unsigned int esize, unsigned int n, unsigned int *available)
 {
@@ -564,7 +1254,7 @@ rte_ring_sc_dequeue_bulk_elem(struct rte_ring *r, void *obj_table,
 }
 
 
-static  unsigned int
+unsigned int
 rte_ring_mc_dequeue_bulk_elem(struct rte_ring *r, void *obj_table,
 		unsigned int esize, unsigned int n, unsigned int *available)
 {
@@ -572,12 +1262,9 @@ rte_ring_mc_dequeue_bulk_elem(struct rte_ring *r, void *obj_table,
 			RTE_RING_QUEUE_FIXED, RTE_RING_SYNC_MT, available);
 }
 
-static  unsigned int rte_ring_dequeue_bulk_elem(
-		struct rte_ring *r,
-		void *obj_table,
-		unsigned int esize,
-		unsigned int n, 
-		unsigned int *available)
+unsigned int
+rte_ring_dequeue_bulk_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
 {
 	switch (r->cons.sync_type) {
 	case RTE_RING_SYNC_MT:
@@ -586,13 +1273,115 @@ static  unsigned int rte_ring_dequeue_bulk_elem(
 	case RTE_RING_SYNC_ST:
 		return rte_ring_sc_dequeue_bulk_elem(r, obj_table, esize, n,
 			available);
+	case RTE_RING_SYNC_MT_RTS:
+		return rte_ring_mc_rts_dequeue_bulk_elem(r, obj_table, esize, n,
+			available);
+	case RTE_RING_SYNC_MT_HTS:
+		return rte_ring_mc_hts_dequeue_bulk_elem(r, obj_table, esize, n,
+			available);
+	}
+	return 0;
+}
+
+
+
+unsigned int
+rte_ring_mc_dequeue_burst_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_dequeue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, RTE_RING_SYNC_MT, available);
+}
+
+
+unsigned int
+rte_ring_sc_dequeue_burst_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_dequeue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, RTE_RING_SYNC_ST, available);
+}
+
+
+unsigned int
+rte_ring_dequeue_burst_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	switch (r->cons.sync_type) {
+	case RTE_RING_SYNC_MT:
+		return rte_ring_mc_dequeue_burst_elem(r, obj_table, esize, n,
+			available);
+	case RTE_RING_SYNC_ST:
+		return rte_ring_sc_dequeue_burst_elem(r, obj_table, esize, n,
+			available);
+	case RTE_RING_SYNC_MT_RTS:
+		return rte_ring_mc_rts_dequeue_burst_elem(r, obj_table, esize,
+			n, available);
+	case RTE_RING_SYNC_MT_HTS:
+		return rte_ring_mc_hts_dequeue_burst_elem(r, obj_table, esize,
+			n, available);
 	}
 	return 0;
 }
 
 
+/* pointer rings, esize == sizeof(void *) */
+unsigned int
+rte_ring_mc_dequeue_bulk(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available)
+{
+	return rte_ring_mc_dequeue_bulk_elem(r, obj_table, sizeof(void *),
+			n, available);
+}
+
+
+unsigned int
+rte_ring_sc_dequeue_bulk(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available)
+{
+	return rte_ring_sc_dequeue_bulk_elem(r, obj_table, sizeof(void *),
+			n, available);
+}
+
+
+unsigned int
+rte_ring_dequeue_bulk(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available)
+{
+	return rte_ring_dequeue_bulk_elem(r, obj_table, sizeof(void *),
+			n, available);
+}
+
+
+unsigned int
+rte_ring_mc_dequeue_burst(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available)
+{
+	return rte_ring_mc_dequeue_burst_elem(r, obj_table, sizeof(void *),
+			n, available);
+}
+
+
+unsigned int
+rte_ring_sc_dequeue_burst(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available)
+{
+	return rte_ring_sc_dequeue_burst_elem(r, obj_table, sizeof(void *),
+			n, available);
+}
+
+
+unsigned int
+rte_ring_dequeue_burst(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available)
+{
+	return rte_ring_dequeue_burst_elem(r, obj_table, sizeof(void *),
+			n, available);
+}
 
-static  int rte_ring_dequeue_elem(struct rte_ring *r, void *obj_p, unsigned int esize)
+
+int
+rte_ring_dequeue_elem(struct rte_ring *r, void *obj_p, unsigned int esize)
 {
 	return rte_ring_dequeue_bulk_elem(r, obj_p, esize, 1, NULL) ? 0 :
 								-ENOENT;
@@ -603,12 +1392,1218 @@ static  int rte_ring_dequeue_elem(struct rte_ring *r, void *obj_p, unsigned int
 	return rte_ring_dequeue_elem(r, obj_p, sizeof(void *));
 }
 
-/* free the ring */
-void rte_ring_free(struct rte_ring *r)
+/*
+ * RTS (relaxed tail sync) mode, see struct rte_ring_rts_headtail.
+ */
+
+/* publish the head as the new tail once every started copy is done */
+static void
+__rte_ring_rts_update_tail(struct rte_ring_rts_headtail *ht)
 {
-	if (r == NULL){
-		free(r);
-		return;
+	union __rte_ring_rts_poscnt h, ot, nt;
+
+	/*
+	 * If other threads are still copying (tail.cnt + 1 != head.cnt),
+	 * only count this one as done and leave tail.pos alone; the last
+	 * thread to finish moves tail.pos up to head.pos.
+	 */
+	ot.raw = __atomic_load_n(&ht->tail.raw, __ATOMIC_ACQUIRE);
+
+	do {
+		/* on 32-bit systems we have to do atomic read here */
+		h.raw = __atomic_load_n(&ht->head.raw, __ATOMIC_RELAXED);
+
+		nt.raw = ot.raw;
+		if (++nt.val.cnt == h.val.cnt)
+			nt.val.pos = h.val.pos;
+
+	} while (__atomic_compare_exchange_n(&ht->tail.raw, &ot.raw, nt.raw,
+			0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE) == 0);
+}
+
+/* wait until the head/tail distance is back under htd_max */
+static void
+__rte_ring_rts_head_wait(const struct rte_ring_rts_headtail *ht,
+		union __rte_ring_rts_poscnt *h)
+{
+	uint32_t max;
+
+	max = ht->htd_max;
+
+	while (h->val.pos - ht->tail.val.pos > max) {
+		rte_pause();
+		h->raw = __atomic_load_n(&ht->head.raw, __ATOMIC_ACQUIRE);
+	}
+}
+
+static unsigned int
+__rte_ring_rts_move_prod_head(struct rte_ring *r, unsigned int num,
+		enum rte_ring_queue_behavior behavior, uint32_t *old_head,
+		uint32_t *free_entries)
+{
+	uint32_t n, cons_tail, tries = 0;
+	union __rte_ring_rts_poscnt nh, oh;
+	const uint32_t capacity = r->capacity;
+
+	oh.raw = __atomic_load_n(&r->rts_prod.head.raw, __ATOMIC_ACQUIRE);
+
+	do {
+		tries++;
+
+		/* Reset n to the initial burst count */
+		n = num;
+
+		/*
+		 * wait for prod head/tail distance,
+		 * make sure that we read prod head *before*
+		 * reading cons tail.
+		 */
+		__rte_ring_rts_head_wait(&r->rts_prod, &oh);
+
+		/*
+		 *  The subtraction is done between two unsigned 32bits value
+		 * (the result is always modulo 32 bits even if we have
+		 * *old_head > cons_tail). So 'free_entries' is always between 0
+		 * and capacity (which is < size).
+		 */
+		cons_tail = __atomic_load_n(&r->cons.tail, __ATOMIC_ACQUIRE);
+		*free_entries = capacity + cons_tail - oh.val.pos;
+
+		/* check that we have enough room in ring */
+		if (unlikely(n > *free_entries))
+			n = (behavior == RTE_RING_QUEUE_FIXED) ?
+					0 : *free_entries;
+
+		if (n == 0)
+			break;
+
+		nh.val.pos = oh.val.pos + n;
+		nh.val.cnt = oh.val.cnt + 1;
+
+	/*
+	 * this CAS(ACQUIRE, ACQUIRE) serves as a hoist barrier to prevent:
+	 *  - OOO reads of cons tail value
+	 *  - OOO copy of elems to the ring
+	 */
+	} while (__atomic_compare_exchange_n(&r->rts_prod.head.raw,
+			&oh.raw, nh.raw,
+			0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE) == 0);
+
+	__RTE_RING_STAT_ADD(r, enq_cas_retries, tries - 1);
+	*old_head = oh.val.pos;
+	return n;
+}
+
+static unsigned int
+__rte_ring_rts_move_cons_head(struct rte_ring *r, unsigned int num,
+		enum rte_ring_queue_behavior behavior, uint32_t *old_head,
+		uint32_t *entries)
+{
+	uint32_t n, prod_tail, tries = 0;
+	union __rte_ring_rts_poscnt nh, oh;
+
+	oh.raw = __atomic_load_n(&r->rts_cons.head.raw, __ATOMIC_ACQUIRE);
+
+	/* move cons.head atomically */
+	do {
+		tries++;
+
+		/* Restore n as it may change every loop */
+		n = num;
+
+		/*
+		 * wait for cons head/tail distance,
+		 * make sure that we read cons head *before*
+		 * reading prod tail.
+		 */
+		__rte_ring_rts_head_wait(&r->rts_cons, &oh);
+
+		/* The subtraction is done between two unsigned 32bits value
+		 * (the result is always modulo 32 bits even if we have
+		 * cons_head > prod_tail). So 'entries' is always between 0
+		 * and size(ring)-1.
+		 */
+		prod_tail = __atomic_load_n(&r->prod.tail, __ATOMIC_ACQUIRE);
+		*entries = prod_tail - oh.val.pos;
+
+		/* Set the actual entries for dequeue */
+		if (n > *entries)
+			n = (behavior == RTE_RING_QUEUE_FIXED) ? 0 : *entries;
+
+		if (unlikely(n == 0))
+			break;
+
+		nh.val.pos = oh.val.pos + n;
+		nh.val.cnt = oh.val.cnt + 1;
+
+	/*
+	 * this CAS(ACQUIRE, ACQUIRE) serves as a hoist barrier to prevent:
+	 *  - OOO reads of prod tail value
+	 *  - OOO copy of elems from the ring
+	 */
+	} while (__atomic_compare_exchange_n(&r->rts_cons.head.raw,
+			&oh.raw, nh.raw,
+			0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE) == 0);
+
+	__RTE_RING_STAT_ADD(r, deq_cas_retries, tries - 1);
+	*old_head = oh.val.pos;
+	return n;
+}
+
+static unsigned int
+__rte_ring_do_rts_enqueue_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n,
+		enum rte_ring_queue_behavior behavior, unsigned int *free_space)
+{
+	uint32_t free_entries, head;
+
+	n = __rte_ring_rts_move_prod_head(r, n, behavior, &head, &free_entries);
+	__rte_ring_stat_enq(r, head, n);
+
+	if (n != 0) {
+		__rte_ring_enqueue_elems(r, head, obj_table, esize, n);
+		__rte_ring_rts_update_tail(&r->rts_prod);
+		__rte_ring_wake_consumers(r, n);
+	}
+
+	if (free_space != NULL)
+		*free_space = free_entries - n;
+	return n;
+}
+
+static unsigned int
+__rte_ring_do_rts_dequeue_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n,
+		enum rte_ring_queue_behavior behavior, unsigned int *available)
+{
+	uint32_t entries, head;
+
+	n = __rte_ring_rts_move_cons_head(r, n, behavior, &head, &entries);
+	__rte_ring_stat_deq(r, n);
+
+	if (n != 0) {
+		__rte_ring_dequeue_elems(r, head, obj_table, esize, n);
+		__rte_ring_rts_update_tail(&r->rts_cons);
 	}
+
+	if (available != NULL)
+		*available = entries - n;
+	return n;
+}
+
+
+unsigned int
+rte_ring_mp_rts_enqueue_bulk_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *free_space)
+{
+	return __rte_ring_do_rts_enqueue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_FIXED, free_space);
+}
+
+
+unsigned int
+rte_ring_mp_rts_enqueue_burst_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *free_space)
+{
+	return __rte_ring_do_rts_enqueue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, free_space);
+}
+
+
+unsigned int
+rte_ring_mc_rts_dequeue_bulk_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_rts_dequeue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_FIXED, available);
+}
+
+
+unsigned int
+rte_ring_mc_rts_dequeue_burst_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_rts_dequeue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, available);
+}
+
+
+unsigned int
+rte_ring_mp_rts_enqueue_bulk(struct rte_ring *r, void * const *obj_table,
+		unsigned int n, unsigned int *free_space)
+{
+	return rte_ring_mp_rts_enqueue_bulk_elem(r, obj_table,
+			sizeof(void *), n, free_space);
+}
+
+
+unsigned int
+rte_ring_mp_rts_enqueue_burst(struct rte_ring *r, void * const *obj_table,
+		unsigned int n, unsigned int *free_space)
+{
+	return rte_ring_mp_rts_enqueue_burst_elem(r, obj_table,
+			sizeof(void *), n, free_space);
+}
+
+
+unsigned int
+rte_ring_mc_rts_dequeue_bulk(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available)
+{
+	return rte_ring_mc_rts_dequeue_bulk_elem(r, obj_table,
+			sizeof(void *), n, available);
+}
+
+
+unsigned int
+rte_ring_mc_rts_dequeue_burst(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available)
+{
+	return rte_ring_mc_rts_dequeue_burst_elem(r, obj_table,
+			sizeof(void *), n, available);
+}
+
+
+int
+rte_ring_set_prod_htd_max(struct rte_ring *r, uint32_t v)
+{
+	if (r->prod.sync_type != RTE_RING_SYNC_MT_RTS)
+		return -ENOTSUP;
+
+	if (v > r->capacity)
+		return -EINVAL;
+
+	r->rts_prod.htd_max = v;
+	return 0;
+}
+
+
+int
+rte_ring_get_prod_htd_max(const struct rte_ring *r)
+{
+	if (r->prod.sync_type == RTE_RING_SYNC_MT_RTS)
+		return r->rts_prod.htd_max;
+	return -ENOTSUP;
+}
+
+
+int
+rte_ring_set_cons_htd_max(struct rte_ring *r, uint32_t v)
+{
+	if (r->cons.sync_type != RTE_RING_SYNC_MT_RTS)
+		return -ENOTSUP;
+
+	if (v > r->capacity)
+		return -EINVAL;
+
+	r->rts_cons.htd_max = v;
+	return 0;
+}
+
+
+int
+rte_ring_get_cons_htd_max(const struct rte_ring *r)
+{
+	if (r->cons.sync_type == RTE_RING_SYNC_MT_RTS)
+		return r->rts_cons.htd_max;
+	return -ENOTSUP;
+}
+
+/*
+ * HTS (head/tail sync) mode, see struct rte_ring_hts_headtail.
+ */
+
+/* finish the current enqueue/dequeue: tail catches up with head */
+static void
+__rte_ring_hts_update_tail(struct rte_ring_hts_headtail *ht, uint32_t old_tail,
+		uint32_t num)
+{
+	uint32_t tail;
+
+	tail = old_tail + num;
+	__atomic_store_n(&ht->ht.pos.tail, tail, __ATOMIC_RELEASE);
+}
+
+/* wait for the previous enqueue/dequeue to finish: head == tail */
+static void
+__rte_ring_hts_head_wait(const struct rte_ring_hts_headtail *ht,
+		union __rte_ring_hts_pos *p)
+{
+	while (p->pos.head != p->pos.tail) {
+		rte_pause();
+		p->raw = __atomic_load_n(&ht->ht.raw, __ATOMIC_ACQUIRE);
+	}
+}
+
+static unsigned int
+__rte_ring_hts_move_prod_head(struct rte_ring *r, unsigned int num,
+		enum rte_ring_queue_behavior behavior, uint32_t *old_head,
+		uint32_t *free_entries)
+{
+	uint32_t n, cons_tail, tries = 0;
+	union __rte_ring_hts_pos np, op;
+	const uint32_t capacity = r->capacity;
+
+	op.raw = __atomic_load_n(&r->hts_prod.ht.raw, __ATOMIC_ACQUIRE);
+
+	do {
+		tries++;
+
+		/* Reset n to the initial burst count */
+		n = num;
+
+		/*
+		 * wait for tail to be equal to head,
+		 * make sure that we read prod head/tail *before*
+		 * reading cons tail.
+		 */
+		__rte_ring_hts_head_wait(&r->hts_prod, &op);
+
+		/*
+		 *  The subtraction is done between two unsigned 32bits value
+		 * (the result is always modulo 32 bits even if we have
+		 * *old_head > cons_tail). So 'free_entries' is always between 0
+		 * and capacity (which is < size).
+		 */
+		cons_tail = __atomic_load_n(&r->cons.tail, __ATOMIC_ACQUIRE);
+		*free_entries = capacity + cons_tail - op.pos.head;
+
+		/* check that we have enough room in ring */
+		if (unlikely(n > *free_entries))
+			n = (behavior == RTE_RING_QUEUE_FIXED) ?
+					0 : *free_entries;
+
+		if (n == 0)
+			break;
+
+		np.pos.tail = op.pos.tail;
+		np.pos.head = op.pos.head + n;
+
+	/*
+	 * this CAS(ACQUIRE, ACQUIRE) serves as a hoist barrier to prevent:
+	 *  - OOO reads of cons tail value
+	 *  - OOO copy of elems from the ring
+	 */
+	} while (__atomic_compare_exchange_n(&r->hts_prod.ht.raw,
+			&op.raw, np.raw,
+			0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE) == 0);
+
+	__RTE_RING_STAT_ADD(r, enq_cas_retries, tries - 1);
+	*old_head = op.pos.head;
+	return n;
+}
+
+static unsigned int
+__rte_ring_hts_move_cons_head(struct rte_ring *r, unsigned int num,
+		enum rte_ring_queue_behavior behavior, uint32_t *old_head,
+		uint32_t *entries)
+{
+	uint32_t n, prod_tail, tries = 0;
+	union __rte_ring_hts_pos np, op;
+
+	op.raw = __atomic_load_n(&r->hts_cons.ht.raw, __ATOMIC_ACQUIRE);
+
+	/* move cons.head atomically */
+	do {
+		tries++;
+
+		/* Restore n as it may change every loop */
+		n = num;
+
+		/*
+		 * wait for tail to be equal to head,
+		 * make sure that we read cons head/tail *before*
+		 * reading prod tail.
+		 */
+		__rte_ring_hts_head_wait(&r->hts_cons, &op);
+
+		/* The subtraction is done between two unsigned 32bits value
+		 * (the result is always modulo 32 bits even if we have
+		 * cons_head > prod_tail). So 'entries' is always between 0
+		 * and size(ring)-1.
+		 */
+		prod_tail = __atomic_load_n(&r->prod.tail, __ATOMIC_ACQUIRE);
+		*entries = prod_tail - op.pos.head;
+
+		/* Set the actual entries for dequeue */
+		if (n > *entries)
+			n = (behavior == RTE_RING_QUEUE_FIXED) ? 0 : *entries;
+
+		if (unlikely(n == 0))
+			break;
+
+		np.pos.tail = op.pos.tail;
+		np.pos.head = op.pos.head + n;
+
+	/*
+	 * this CAS(ACQUIRE, ACQUIRE) serves as a hoist barrier to prevent:
+	 *  - OOO reads of prod tail value
+	 *  - OOO copy of elems from the ring
+	 */
+	} while (__atomic_compare_exchange_n(&r->hts_cons.ht.raw,
+			&op.raw, np.raw,
+			0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE) == 0);
+
+	__RTE_RING_STAT_ADD(r, deq_cas_retries, tries - 1);
+	*old_head = op.pos.head;
+	return n;
+}
+
+static unsigned int
+__rte_ring_do_hts_enqueue_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n,
+		enum rte_ring_queue_behavior behavior, unsigned int *free_space)
+{
+	uint32_t free_entries, head;
+
+	n = __rte_ring_hts_move_prod_head(r, n, behavior, &head, &free_entries);
+	__rte_ring_stat_enq(r, head, n);
+
+	if (n != 0) {
+		__rte_ring_enqueue_elems(r, head, obj_table, esize, n);
+		__rte_ring_hts_update_tail(&r->hts_prod, head, n);
+		__rte_ring_wake_consumers(r, n);
+	}
+
+	if (free_space != NULL)
+		*free_space = free_entries - n;
+	return n;
+}
+
+static unsigned int
+__rte_ring_do_hts_dequeue_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n,
+		enum rte_ring_queue_behavior behavior, unsigned int *available)
+{
+	uint32_t entries, head;
+
+	n = __rte_ring_hts_move_cons_head(r, n, behavior, &head, &entries);
+	__rte_ring_stat_deq(r, n);
+
+	if (n != 0) {
+		__rte_ring_dequeue_elems(r, head, obj_table, esize, n);
+		__rte_ring_hts_update_tail(&r->hts_cons, head, n);
+	}
+
+	if (available != NULL)
+		*available = entries - n;
+	return n;
+}
+
+
+unsigned int
+rte_ring_mp_hts_enqueue_bulk_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *free_space)
+{
+	return __rte_ring_do_hts_enqueue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_FIXED, free_space);
+}
+
+
+unsigned int
+rte_ring_mp_hts_enqueue_burst_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *free_space)
+{
+	return __rte_ring_do_hts_enqueue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, free_space);
+}
+
+
+unsigned int
+rte_ring_mc_hts_dequeue_bulk_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_hts_dequeue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_FIXED, available);
+}
+
+
+unsigned int
+rte_ring_mc_hts_dequeue_burst_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_hts_dequeue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, available);
+}
+
+
+unsigned int
+rte_ring_mp_hts_enqueue_bulk(struct rte_ring *r, void * const *obj_table,
+		unsigned int n, unsigned int *free_space)
+{
+	return rte_ring_mp_hts_enqueue_bulk_elem(r, obj_table,
+			sizeof(void *), n, free_space);
+}
+
+
+unsigned int
+rte_ring_mp_hts_enqueue_burst(struct rte_ring *r, void * const *obj_table,
+		unsigned int n, unsigned int *free_space)
+{
+	return rte_ring_mp_hts_enqueue_burst_elem(r, obj_table,
+			sizeof(void *), n, free_space);
+}
+
+
+unsigned int
+rte_ring_mc_hts_dequeue_bulk(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available)
+{
+	return rte_ring_mc_hts_dequeue_bulk_elem(r, obj_table,
+			sizeof(void *), n, available);
+}
+
+
+unsigned int
+rte_ring_mc_hts_dequeue_burst(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available)
+{
+	return rte_ring_mc_hts_dequeue_burst_elem(r, obj_table,
+			sizeof(void *), n, available);
+}
+
+/*
+ * Zero-copy API. Only for ST and HTS producers/consumers: they are the
+ * only modes where a single thread sits between the head and tail moves,
+ * so the reserved slots can be handed out and the tail set directly.
+ */
+
+/* number of objects between head and tail of an ST side */
+static uint32_t
+__rte_ring_st_get_tail(struct rte_ring_headtail *ht, uint32_t *tail,
+		uint32_t num)
+{
+	uint32_t h, n, t;
+
+	h = ht->head;
+	t = ht->tail;
+	n = h - t;
+
+	num = (n >= num) ? num : 0;
+	*tail = t;
+	return num;
+}
+
+/* finish an ST operation: num objects move, the rest of the reservation
+ * is given back */
+static void
+__rte_ring_st_set_head_tail(struct rte_ring_headtail *ht, uint32_t tail,
+		uint32_t num, uint32_t enqueue)
+{
+	uint32_t pos;
+
+	if (enqueue)
+		rte_smp_wmb();
+	else
+		rte_smp_rmb();
+
+	pos = tail + num;
+	ht->head = pos;
+	__atomic_store_n(&ht->tail, pos, __ATOMIC_RELEASE);
+}
+
+/* number of objects between head and tail of an HTS side */
+static uint32_t
+__rte_ring_hts_get_tail(struct rte_ring_hts_headtail *ht, uint32_t *tail,
+		uint32_t num)
+{
+	uint32_t n;
+	union __rte_ring_hts_pos p;
+
+	p.raw = __atomic_load_n(&ht->ht.raw, __ATOMIC_RELAXED);
+	n = p.pos.head - p.pos.tail;
+
+	num = (n >= num) ? num : 0;
+	*tail = p.pos.tail;
+	return num;
+}
+
+/* finish an HTS operation: num objects move, the rest of the reservation
+ * is given back */
+static void
+__rte_ring_hts_set_head_tail(struct rte_ring_hts_headtail *ht, uint32_t tail,
+		uint32_t num)
+{
+	union __rte_ring_hts_pos p;
+
+	p.pos.head = tail + num;
+	p.pos.tail = p.pos.head;
+
+	__atomic_store_n(&ht->ht.raw, p.raw, __ATOMIC_RELEASE);
+}
+
+/* ring storage of num objects from head, split in two at the wrap */
+static void
+__rte_ring_get_elem_addr(struct rte_ring *r, uint32_t head, uint32_t esize,
+		uint32_t num, void **dst1, uint32_t *n1, void **dst2)
+{
+	uint32_t idx = head & r->mask;
+	char *ring = (char *)&r[1];
+
+	*dst1 = ring + (size_t)idx * esize;
+	*n1 = num;
+
+	if (idx + num > r->size) {
+		*n1 = r->size - idx;
+		*dst2 = ring;
+	} else {
+		*dst2 = NULL;
+	}
+}
+
+static unsigned int
+__rte_ring_do_enqueue_zc_elem_start(struct rte_ring *r, unsigned int esize,
+		uint32_t n, enum rte_ring_queue_behavior behavior,
+		struct rte_ring_zc_data *zcd, unsigned int *free_space)
+{
+	uint32_t free_entries, head, next;
+
+	switch (r->prod.sync_type) {
+	case RTE_RING_SYNC_ST:
+		n = __rte_ring_move_prod_head(r, RTE_RING_SYNC_ST, n,
+			behavior, &head, &next, &free_entries,
+			free_space != NULL);
+		break;
+	case RTE_RING_SYNC_MT_HTS:
+		n = __rte_ring_hts_move_prod_head(r, n, behavior, &head,
+			&free_entries);
+		break;
+	default:
+		/* unsupported mode, shouldn't be here */
+		n = 0;
+		head = 0;
+		free_entries = 0;
+	}
+	__rte_ring_stat_enq(r, head, n);
+
+	if (n != 0)
+		__rte_ring_get_elem_addr(r, head, esize, n, &zcd->ptr1,
+			&zcd->n1, &zcd->ptr2);
+
+	if (free_space != NULL)
+		*free_space = free_entries - n;
+	return n;
+}
+
+static unsigned int
+__rte_ring_do_dequeue_zc_elem_start(struct rte_ring *r, uint32_t esize,
+		uint32_t n, enum rte_ring_queue_behavior behavior,
+		struct rte_ring_zc_data *zcd, unsigned int *available)
+{
+	uint32_t avail, head, next;
+
+	switch (r->cons.sync_type) {
+	case RTE_RING_SYNC_ST:
+		n = __rte_ring_move_cons_head(r, RTE_RING_SYNC_ST, n,
+			behavior, &head, &next, &avail, available != NULL);
+		break;
+	case RTE_RING_SYNC_MT_HTS:
+		n = __rte_ring_hts_move_cons_head(r, n, behavior, &head,
+			&avail);
+		break;
+	default:
+		/* unsupported mode, shouldn't be here */
+		n = 0;
+		avail = 0;
+	}
+	__rte_ring_stat_deq(r, n);
+
+	if (n != 0)
+		__rte_ring_get_elem_addr(r, head, esize, n, &zcd->ptr1,
+			&zcd->n1, &zcd->ptr2);
+
+	if (available != NULL)
+		*available = avail - n;
+	return n;
+}
+
+
+unsigned int
+rte_ring_enqueue_zc_bulk_elem_start(struct rte_ring *r, unsigned int esize,
+		unsigned int n, struct rte_ring_zc_data *zcd,
+		unsigned int *free_space)
+{
+	return __rte_ring_do_enqueue_zc_elem_start(r, esize, n,
+			RTE_RING_QUEUE_FIXED, zcd, free_space);
+}
+
+
+unsigned int
+rte_ring_enqueue_zc_burst_elem_start(struct rte_ring *r, unsigned int esize,
+		unsigned int n, struct rte_ring_zc_data *zcd,
+		unsigned int *free_space)
+{
+	return __rte_ring_do_enqueue_zc_elem_start(r, esize, n,
+			RTE_RING_QUEUE_VARIABLE, zcd, free_space);
+}
+
+
+/* publish n reserved slots, copying obj_table into them unless NULL */
+static void
+__rte_ring_do_enqueue_finish(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n)
+{
+	uint32_t tail;
+
+	switch (r->prod.sync_type) {
+	case RTE_RING_SYNC_ST:
+		n = __rte_ring_st_get_tail(&r->prod, &tail, n);
+		if (n != 0 && obj_table != NULL)
+			__rte_ring_enqueue_elems(r, tail, obj_table, esize, n);
+		__rte_ring_st_set_head_tail(&r->prod, tail, n, 1);
+		break;
+	case RTE_RING_SYNC_MT_HTS:
+		n = __rte_ring_hts_get_tail(&r->hts_prod, &tail, n);
+		if (n != 0 && obj_table != NULL)
+			__rte_ring_enqueue_elems(r, tail, obj_table, esize, n);
+		__rte_ring_hts_set_head_tail(&r->hts_prod, tail, n);
+		break;
+	default:
+		/* unsupported mode, shouldn't be here */
+		return;
+	}
+	if (n != 0)
+		__rte_ring_wake_consumers(r, n);
+}
+
+
+void
+rte_ring_enqueue_zc_elem_finish(struct rte_ring *r, unsigned int n)
+{
+	__rte_ring_do_enqueue_finish(r, NULL, 0, n);
+}
+
+
+unsigned int
+rte_ring_enqueue_zc_bulk_start(struct rte_ring *r, unsigned int n,
+		struct rte_ring_zc_data *zcd, unsigned int *free_space)
+{
+	return rte_ring_enqueue_zc_bulk_elem_start(r, sizeof(uintptr_t), n,
+			zcd, free_space);
+}
+
+
+unsigned int
+rte_ring_enqueue_zc_burst_start(struct rte_ring *r, unsigned int n,
+		struct rte_ring_zc_data *zcd, unsigned int *free_space)
+{
+	return rte_ring_enqueue_zc_burst_elem_start(r, sizeof(uintptr_t), n,
+			zcd, free_space);
+}
+
+
+void
+rte_ring_enqueue_zc_finish(struct rte_ring *r, unsigned int n)
+{
+	rte_ring_enqueue_zc_elem_finish(r, n);
+}
+
+
+unsigned int
+rte_ring_dequeue_zc_bulk_elem_start(struct rte_ring *r, unsigned int esize,
+		unsigned int n, struct rte_ring_zc_data *zcd,
+		unsigned int *available)
+{
+	return __rte_ring_do_dequeue_zc_elem_start(r, esize, n,
+			RTE_RING_QUEUE_FIXED, zcd, available);
+}
+
+
+unsigned int
+rte_ring_dequeue_zc_burst_elem_start(struct rte_ring *r, unsigned int esize,
+		unsigned int n, struct rte_ring_zc_data *zcd,
+		unsigned int *available)
+{
+	return __rte_ring_do_dequeue_zc_elem_start(r, esize, n,
+			RTE_RING_QUEUE_VARIABLE, zcd, available);
+}
+
+
+void
+rte_ring_dequeue_zc_elem_finish(struct rte_ring *r, unsigned int n)
+{
+	rte_ring_dequeue_elem_finish(r, n);
+}
+
+
+unsigned int
+rte_ring_dequeue_zc_bulk_start(struct rte_ring *r, unsigned int n,
+		struct rte_ring_zc_data *zcd, unsigned int *available)
+{
+	return rte_ring_dequeue_zc_bulk_elem_start(r, sizeof(uintptr_t), n,
+			zcd, available);
+}
+
+
+unsigned int
+rte_ring_dequeue_zc_burst_start(struct rte_ring *r, unsigned int n,
+		struct rte_ring_zc_data *zcd, unsigned int *available)
+{
+	return rte_ring_dequeue_zc_burst_elem_start(r, sizeof(uintptr_t), n,
+			zcd, available);
+}
+
+
+void
+rte_ring_dequeue_zc_finish(struct rte_ring *r, unsigned int n)
+{
+	rte_ring_dequeue_zc_elem_finish(r, n);
+}
+
+/*
+ * Peek API, for ST and HTS producers/consumers only, see the zero-copy API.
+ * A consumer copies up to n objects out with a _start call, looks at them
+ * and then commits any prefix of them with _finish; the objects it does
+ * not commit stay at the head of the ring, in order.
+ */
+
+static unsigned int
+__rte_ring_do_enqueue_start(struct rte_ring *r, uint32_t n,
+		enum rte_ring_queue_behavior behavior, unsigned int *free_space)
+{
+	uint32_t free_entries, head, next;
+
+	switch (r->prod.sync_type) {
+	case RTE_RING_SYNC_ST:
+		n = __rte_ring_move_prod_head(r, RTE_RING_SYNC_ST, n,
+			behavior, &head, &next, &free_entries,
+			free_space != NULL);
+		break;
+	case RTE_RING_SYNC_MT_HTS:
+		n = __rte_ring_hts_move_prod_head(r, n, behavior, &head,
+			&free_entries);
+		break;
+	default:
+		/* unsupported mode, shouldn't be here */
+		n = 0;
+		head = 0;
+		free_entries = 0;
+	}
+	__rte_ring_stat_enq(r, head, n);
+
+	if (free_space != NULL)
+		*free_space = free_entries - n;
+	return n;
+}
+
+static unsigned int
+__rte_ring_do_dequeue_start(struct rte_ring *r, void *obj_table,
+		unsigned int esize, uint32_t n,
+		enum rte_ring_queue_behavior behavior, unsigned int *available)
+{
+	uint32_t avail, head, next;
+
+	switch (r->cons.sync_type) {
+	case RTE_RING_SYNC_ST:
+		n = __rte_ring_move_cons_head(r, RTE_RING_SYNC_ST, n,
+			behavior, &head, &next, &avail, available != NULL);
+		break;
+	case RTE_RING_SYNC_MT_HTS:
+		n = __rte_ring_hts_move_cons_head(r, n, behavior, &head,
+			&avail);
+		break;
+	default:
+		/* unsupported mode, shouldn't be here */
+		n = 0;
+		avail = 0;
+	}
+	__rte_ring_stat_deq(r, n);
+
+	if (n != 0)
+		__rte_ring_dequeue_elems(r, head, obj_table, esize, n);
+
+	if (available != NULL)
+		*available = avail - n;
+	return n;
+}
+
+
+unsigned int
+rte_ring_enqueue_bulk_elem_start(struct rte_ring *r, unsigned int n,
+		unsigned int *free_space)
+{
+	return __rte_ring_do_enqueue_start(r, n, RTE_RING_QUEUE_FIXED,
+			free_space);
+}
+
+
+unsigned int
+rte_ring_enqueue_burst_elem_start(struct rte_ring *r, unsigned int n,
+		unsigned int *free_space)
+{
+	return __rte_ring_do_enqueue_start(r, n, RTE_RING_QUEUE_VARIABLE,
+			free_space);
+}
+
+
+void
+rte_ring_enqueue_elem_finish(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n)
+{
+	__rte_ring_do_enqueue_finish(r, obj_table, esize, n);
+}
+
+
+unsigned int
+rte_ring_enqueue_bulk_start(struct rte_ring *r, unsigned int n,
+		unsigned int *free_space)
+{
+	return rte_ring_enqueue_bulk_elem_start(r, n, free_space);
+}
+
+
+unsigned int
+rte_ring_enqueue_burst_start(struct rte_ring *r, unsigned int n,
+		unsigned int *free_space)
+{
+	return rte_ring_enqueue_burst_elem_start(r, n, free_space);
+}
+
+
+void
+rte_ring_enqueue_finish(struct rte_ring *r, void * const *obj_table,
+		unsigned int n)
+{
+	rte_ring_enqueue_elem_finish(r, obj_table, sizeof(uintptr_t), n);
+}
+
+
+unsigned int
+rte_ring_dequeue_bulk_elem_start(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_dequeue_start(r, obj_table, esize, n,
+			RTE_RING_QUEUE_FIXED, available);
+}
+
+
+unsigned int
+rte_ring_dequeue_burst_elem_start(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_dequeue_start(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, available);
+}
+
+
+void
+rte_ring_dequeue_elem_finish(struct rte_ring *r, unsigned int n)
+{
+	uint32_t tail;
+
+	switch (r->cons.sync_type) {
+	case RTE_RING_SYNC_ST:
+		n = __rte_ring_st_get_tail(&r->cons, &tail, n);
+		__rte_ring_st_set_head_tail(&r->cons, tail, n, 0);
+		break;
+	case RTE_RING_SYNC_MT_HTS:
+		n = __rte_ring_hts_get_tail(&r->hts_cons, &tail, n);
+		__rte_ring_hts_set_head_tail(&r->hts_cons, tail, n);
+		break;
+	default:
+		/* unsupported mode, shouldn't be here */
+		break;
+	}
+}
+
+
+unsigned int
+rte_ring_dequeue_bulk_start(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available)
+{
+	return rte_ring_dequeue_bulk_elem_start(r, obj_table,
+			sizeof(uintptr_t), n, available);
+}
+
+
+unsigned int
+rte_ring_dequeue_burst_start(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available)
+{
+	return rte_ring_dequeue_burst_elem_start(r, obj_table,
+			sizeof(uintptr_t), n, available);
+}
+
+
+void
+rte_ring_dequeue_finish(struct rte_ring *r, unsigned int n)
+{
+	rte_ring_dequeue_elem_finish(r, n);
+}
+
+/*
+ * Blocking dequeue, see RING_F_DEQ_WAIT.
+ */
+
+#define RTE_RING_WAIT_FOREVER UINT64_MAX
+
+static uint64_t
+__rte_ring_clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Sleep on prod.tail unless objects showed up after we registered as a
+ * waiter. A producer that published before the registration is caught by
+ * the tail check, one that published after it sees deq_waiters != 0.
+ */
+static void
+__rte_ring_dequeue_sleep(struct rte_ring *r, uint64_t timeout_ns)
+{
+	struct timespec ts, *pts = NULL;
+	uint32_t tail;
+
+	if (timeout_ns != RTE_RING_WAIT_FOREVER) {
+		ts.tv_sec = timeout_ns / 1000000000ULL;
+		ts.tv_nsec = timeout_ns % 1000000000ULL;
+		pts = &ts;
+	}
+
+	__atomic_add_fetch(&r->deq_waiters, 1, __ATOMIC_SEQ_CST);
+	tail = __atomic_load_n(&r->prod.tail, __ATOMIC_SEQ_CST);
+	if (tail == __atomic_load_n(&r->cons.tail, __ATOMIC_RELAXED))
+		__rte_ring_futex(&r->prod.tail, FUTEX_WAIT, tail, pts);
+	__atomic_sub_fetch(&r->deq_waiters, 1, __ATOMIC_RELAXED);
+}
+
+static unsigned int
+__rte_ring_do_dequeue_wait(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available,
+		uint64_t timeout_ns)
+{
+	uint64_t deadline = 0, now;
+	unsigned int i, ret;
+
+	ret = rte_ring_dequeue_burst_elem(r, obj_table, esize, n, available);
+	if (likely(ret != 0) || n == 0)
+		return ret;
+
+	if (timeout_ns != RTE_RING_WAIT_FOREVER)
+		deadline = __rte_ring_clock_ns() + timeout_ns;
+
+	for (;;) {
+		for (i = 0; i < RTE_RING_WAIT_SPINS; i++) {
+			ret = rte_ring_dequeue_burst_elem(r, obj_table, esize,
+					n, available);
+			if (ret != 0)
+				return ret;
+			rte_pause();
+		}
+
+		timeout_ns = RTE_RING_WAIT_FOREVER;
+		if (deadline != 0) {
+			now = __rte_ring_clock_ns();
+			if (now >= deadline)
+				return 0;
+			timeout_ns = deadline - now;
+		}
+
+		if (r->flags & RING_F_DEQ_WAIT)
+			__rte_ring_dequeue_sleep(r, timeout_ns);
+	}
+}
+
+unsigned int
+rte_ring_dequeue_burst_elem_wait(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_dequeue_wait(r, obj_table, esize, n, available,
+			RTE_RING_WAIT_FOREVER);
+}
+
+unsigned int
+rte_ring_dequeue_burst_elem_timedwait(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available,
+		uint64_t timeout_ns)
+{
+	if (timeout_ns == RTE_RING_WAIT_FOREVER)
+		timeout_ns--;
+	return __rte_ring_do_dequeue_wait(r, obj_table, esize, n, available,
+			timeout_ns);
+}
+
+unsigned int
+rte_ring_dequeue_burst_wait(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available)
+{
+	return rte_ring_dequeue_burst_elem_wait(r, obj_table, sizeof(void *),
+			n, available);
+}
+
+unsigned int
+rte_ring_dequeue_burst_timedwait(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available, uint64_t timeout_ns)
+{
+	return rte_ring_dequeue_burst_elem_timedwait(r, obj_table,
+			sizeof(void *), n, available, timeout_ns);
+}
+
+int
+rte_ring_dequeue_wait(struct rte_ring *r, void **obj_p)
+{
+	rte_ring_dequeue_burst_wait(r, obj_p, 1, NULL);
+	return 0;
+}
+
+int
+rte_ring_dequeue_timedwait(struct rte_ring *r, void **obj_p,
+		uint64_t timeout_ns)
+{
+	return rte_ring_dequeue_burst_timedwait(r, obj_p, 1, NULL,
+			timeout_ns) ? 0 : -ETIMEDOUT;
+}
+
+
+int
+rte_ring_stats_get(const struct rte_ring *r, struct rte_ring_stats *stats)
+{
+#ifdef RTE_RING_STATS
+	const struct rte_ring_stats *st;
+	unsigned int i;
+
+	memset(stats, 0, sizeof(*stats));
+	for (i = 0; i < RTE_RING_STATS_SLOTS; i++) {
+		st = &r->stats[i].s;
+		stats->enq_success_bulk += st->enq_success_bulk;
+		stats->enq_success_objs += st->enq_success_objs;
+		stats->enq_fail_bulk += st->enq_fail_bulk;
+		stats->enq_cas_retries += st->enq_cas_retries;
+		stats->deq_success_bulk += st->deq_success_bulk;
+		stats->deq_success_objs += st->deq_success_objs;
+		stats->deq_fail_bulk += st->deq_fail_bulk;
+		stats->deq_cas_retries += st->deq_cas_retries;
+	}
+	stats->watermark = __atomic_load_n(&r->watermark, __ATOMIC_RELAXED);
+	return 0;
+#else
+	(void)r;
+	memset(stats, 0, sizeof(*stats));
+	return -ENOTSUP;
+#endif
+}
+
+void
+rte_ring_stats_reset(struct rte_ring *r)
+{
+#ifdef RTE_RING_STATS
+	memset(r->stats, 0, sizeof(r->stats));
+	__atomic_store_n(&r->watermark, 0, __ATOMIC_RELAXED);
+#else
+	(void)r;
+#endif
+}
+
+
+/* free the ring */
+void rte_ring_free(struct rte_ring *r)
+{
+	if (r == NULL)
+		return;
+
+	free(r);
 }
 
@@ -1,7 +1,21 @@
 #ifndef RING_H_
 #define RING_H_
 #include <stdint.h>
+#include <sys/types.h>
+#if defined(__x86_64__) || defined(__i386__)
 #include <immintrin.h>
+#endif
+
+/*
+ * RTE_USE_C11_MEM_MODEL selects the C11 acquire/release version of the
+ * MP/MC head/tail protocol in ring.c (build with -DRTE_USE_C11_MEM_MODEL).
+ * The default version relies on x86 store ordering, so other architectures
+ * always use the C11 one.
+ */
+#if !defined(__x86_64__) && !defined(__i386__) && \
+	!defined(RTE_USE_C11_MEM_MODEL)
+#define RTE_USE_C11_MEM_MODEL
+#endif
 
 /* true if x is a power of 2 */
 #define POWEROF2(x) ((((x)-1) & (x)) == 0)
@@ -15,13 +29,27 @@
 #define RING_F_MP_RTS_ENQ 0x0008 /**< The default enqueue is "MP RTS". */
 #define RING_F_MC_RTS_DEQ 0x0010 /**< The default dequeue is "MC RTS". */
 
+#define RING_F_MP_HTS_ENQ 0x0020 /**< The default enqueue is "MP HTS". */
+#define RING_F_MC_HTS_DEQ 0x0040 /**< The default dequeue is "MC HTS". */
+
+/*
+ * Consumers may sleep in the *_wait dequeue calls; producers then wake them
+ * through a futex on prod.tail. Without this flag the wait calls only spin.
+ */
+#define RING_F_DEQ_WAIT 0x0080
+
 
 /* mask of all valid flag values to ring_create() */
 #define RING_F_MASK (RING_F_SP_ENQ | RING_F_SC_DEQ | RING_F_EXACT_SZ | \
-		     RING_F_MP_RTS_ENQ | RING_F_MC_RTS_DEQ )
+		     RING_F_MP_RTS_ENQ | RING_F_MC_RTS_DEQ | \
+		     RING_F_MP_HTS_ENQ | RING_F_MC_HTS_DEQ | \
+		     RING_F_DEQ_WAIT)
 
 #define RTE_CACHE_LINE_SIZE 64
 
+/** Force alignment to cache line. */
+#define __rte_cache_aligned __attribute__((__aligned__(RTE_CACHE_LINE_SIZE)))
+
 #define RTE_ALIGN_FLOOR(val, align) \
 	(typeof(val))((val) & (~((typeof(val))((align) - 1))))
 
@@ -47,27 +75,174 @@ enum rte_ring_queue_behavior {
 enum rte_ring_sync_type {
 	RTE_RING_SYNC_MT,     /**< multi-thread safe (default mode) */
 	RTE_RING_SYNC_ST,     /**< single thread only */
+	RTE_RING_SYNC_MT_RTS, /**< multi-thread relaxed tail sync */
+	RTE_RING_SYNC_MT_HTS, /**< multi-thread head/tail sync */
 };
 
 struct rte_ring_headtail {
 	volatile uint32_t head;      /**< prod/consumer head. */
 	volatile uint32_t tail;      /**< prod/consumer tail. */
 	enum rte_ring_sync_type sync_type;
+	/**
+	 * Single producer/consumer only: private copy of the other side's
+	 * tail. A stale copy only underestimates the free room (entries), so
+	 * it is refreshed only when the ring looks too full (empty), when the
+	 * caller asks for free_space (available), or when it trails the head
+	 * by more than the capacity. Multi producer/consumer calls on the same
+	 * side also store the tail they read, for rings that mix both kinds.
+	 */
+	uint32_t cache_tail;
+};
+
+/** @internal RTS position and update counter, changed by one 64 bit CAS. */
+union __rte_ring_rts_poscnt {
+	uint64_t raw;
+	struct {
+		uint32_t cnt; /**< head/tail reference counter */
+		uint32_t pos; /**< head/tail position */
+	} val;
+};
+
+/**
+ * RTS (relaxed tail sync) head/tail. Every head move bumps head.cnt and
+ * every finished copy bumps tail.cnt; whichever thread brings tail.cnt up
+ * to head.cnt publishes head.pos as the new tail. A thread finishing early
+ * therefore never waits for a slower one, unlike update_tail() in MT mode.
+ * htd_max bounds how far head may run ahead of tail, so a preempted thread
+ * can only hold back that many entries.
+ *
+ * tail.val.pos sits at the offset of rte_ring_headtail.tail and sync_type
+ * at the same offset in both structures, so the other side of the ring
+ * reads an RTS tail like a plain one.
+ */
+struct rte_ring_rts_headtail {
+	volatile union __rte_ring_rts_poscnt tail;
+	enum rte_ring_sync_type sync_type;  /**< sync type of prod/cons */
+	uint32_t htd_max;   /**< max allowed distance between head/tail */
+	volatile union __rte_ring_rts_poscnt head;
 };
 
+/** @internal HTS head and tail, changed together by one 64 bit CAS. */
+union __rte_ring_hts_pos {
+	uint64_t raw;
+	struct {
+		uint32_t head; /**< head position */
+		uint32_t tail; /**< tail position */
+	} pos;
+};
+
+/**
+ * HTS (head/tail sync) head/tail. A thread may only move the head while
+ * head == tail, i.e. once the previous enqueue (or dequeue) has completed,
+ * so only one producer (consumer) at a time is between head and tail
+ * moves. That makes peek, zero-copy and in-place updates safe with several
+ * producers/consumers, and a preempted thread holds up the others only for
+ * its own copy instead of chaining tail waits as in MT mode.
+ *
+ * The cost is that copies are serialized: in MT mode several threads copy
+ * into the ring at once, in HTS mode the next one waits for the current
+ * one to finish. With short copies and no preemption HTS throughput is
+ * therefore below MT mode, and the gap grows with the number of threads
+ * contending on the same side.
+ *
+ * pos.tail and sync_type sit at the offsets of rte_ring_headtail.tail and
+ * sync_type, so the other side of the ring reads an HTS tail like a plain
+ * one.
+ */
+struct rte_ring_hts_headtail {
+	volatile union __rte_ring_hts_pos ht;
+	enum rte_ring_sync_type sync_type;  /**< sync type of prod/cons */
+};
+
+/**
+ * Ring storage handed out by the zero-copy API. The n objects reserved
+ * start at ptr1; when they wrap around the end of the ring, the first n1
+ * are at ptr1 and the rest at ptr2, otherwise ptr2 is NULL and n1 == n.
+ */
+struct rte_ring_zc_data {
+	void *ptr1;       /**< first part of the reserved storage */
+	void *ptr2;       /**< storage after the wrap, or NULL */
+	unsigned int n1;  /**< number of objects at ptr1 */
+} __rte_cache_aligned;
+
+/**
+ * Ring statistics, see rte_ring_stats_get(). Only collected when ring.c is
+ * built with -DRTE_RING_STATS; the ring user must be built with the same
+ * setting since it changes the size of struct rte_ring.
+ */
+struct rte_ring_stats {
+	uint64_t enq_success_bulk;  /**< enqueue calls that moved objects */
+	uint64_t enq_success_objs;  /**< objects enqueued */
+	uint64_t enq_fail_bulk;     /**< enqueue calls that moved nothing */
+	uint64_t enq_cas_retries;   /**< lost producer head CAS */
+	uint64_t deq_success_bulk;  /**< dequeue calls that moved objects */
+	uint64_t deq_success_objs;  /**< objects dequeued */
+	uint64_t deq_fail_bulk;     /**< dequeue calls that moved nothing */
+	uint64_t deq_cas_retries;   /**< lost consumer head CAS */
+	uint32_t watermark;         /**< highest occupancy seen */
+};
+
+/*
+ * Counters are kept in one slot per thread, so updating them needs no
+ * atomics; a thread gets the next slot on its first ring call. With more
+ * than RTE_RING_STATS_SLOTS threads, slots are shared and the counts of
+ * the sharing threads are approximate.
+ */
+#ifndef RTE_RING_STATS_SLOTS
+#define RTE_RING_STATS_SLOTS 64
+#endif
+
+/** @internal one thread's counters, on their own cache line */
+struct rte_ring_stats_slot {
+	struct rte_ring_stats s;
+} __rte_cache_aligned;
+
+/**
+ * The read-mostly fields, the producer and the consumer each get their own
+ * cache line, with an empty line in between so that adjacent line prefetch
+ * does not pull the other side's line in either. The producer and the
+ * consumer then only share a line when one reads the other's tail.
+ */
 struct rte_ring {
 	int flags;               /**< Flags supplied at creation. */
 	uint32_t size;           /**< Size of ring. */
 	uint32_t mask;           /**< Mask (size-1) of ring. */
 	uint32_t capacity;       /**< Usable size of ring */
 
+	char pad0 __rte_cache_aligned; /**< empty cache line */
+
 	/** Ring producer status. */
-	struct rte_ring_headtail prod;
+	struct {
+		union {
+			struct rte_ring_headtail prod;
+			struct rte_ring_rts_headtail rts_prod;
+			struct rte_ring_hts_headtail hts_prod;
+		};
+		/** consumers asleep on prod.tail, RING_F_DEQ_WAIT only */
+		volatile uint32_t deq_waiters;
+	} __rte_cache_aligned;
+
+	char pad1 __rte_cache_aligned; /**< empty cache line */
 
 	/** Ring consumer status. */
-	struct rte_ring_headtail cons;
+	union {
+		struct rte_ring_headtail cons;
+		struct rte_ring_rts_headtail rts_cons;
+		struct rte_ring_hts_headtail hts_cons;
+	} __rte_cache_aligned;
+
+	char pad2 __rte_cache_aligned; /**< empty cache line */
+
+#ifdef RTE_RING_STATS
+	/** per thread counters, the watermark field is unused */
+	struct rte_ring_stats_slot stats[RTE_RING_STATS_SLOTS];
+	uint32_t watermark __rte_cache_aligned; /**< highest occupancy seen */
+	char pad3 __rte_cache_aligned; /**< empty cache line */
+#endif
 };
 
+#if defined(__x86_64__) || defined(__i386__)
+
 #define MPLOCKED        "lock ; "       /**< Insert MP lock prefix. */
 
 static inline int
@@ -88,6 +263,17 @@ rte_atomic32_cmpset(volatile uint32_t *dst, uint32_t exp, uint32_t src)
 	return res;
 }
 
+#else
+
+static inline int
+rte_atomic32_cmpset(volatile uint32_t *dst, uint32_t exp, uint32_t src)
+{
+	return __atomic_compare_exchange_n(dst, &exp, src, 0,
+			__ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE);
+}
+
+#endif
+
 static inline uint32_t rte_combine32ms1b(uint32_t x)
 {
 	x |= x >> 1;
@@ -109,12 +295,346 @@ static inline uint32_t rte_align32pow2(uint32_t x)
 
 static inline void rte_pause(void)
 {
+#if defined(__x86_64__) || defined(__i386__)
 	_mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	asm volatile("yield" : : : "memory");
+#endif
 }
 
-int rte_ring_enqueue(struct rte_ring *r, void *obj);
-int rte_ring_dequeue(struct rte_ring *r, void **obj_p);
+#define rte_compiler_barrier() do {		\
+	asm volatile ("" : : : "memory");	\
+} while (0)
+
+#if defined(__x86_64__) || defined(__i386__)
+/*
+ * x86 keeps stores and loads in order (TSO), so the SMP barriers only
+ * have to stop the compiler from reordering accesses.
+ */
+#define rte_smp_wmb() rte_compiler_barrier()
+#define rte_smp_rmb() rte_compiler_barrier()
+#else
+#define rte_smp_wmb() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define rte_smp_rmb() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#endif
+
+/**
+ * Number of entries in the ring.
+ */
+static inline unsigned int
+rte_ring_count(const struct rte_ring *r)
+{
+	uint32_t prod_tail = r->prod.tail;
+	uint32_t cons_tail = r->cons.tail;
+	uint32_t count = (prod_tail - cons_tail) & r->mask;
+
+	return (count > r->capacity) ? r->capacity : count;
+}
+
+/**
+ * Number of free entries in the ring.
+ */
+static inline unsigned int
+rte_ring_free_count(const struct rte_ring *r)
+{
+	return r->capacity - rte_ring_count(r);
+}
+
+/**
+ * 1 if the ring is full, 0 otherwise.
+ */
+static inline int
+rte_ring_full(const struct rte_ring *r)
+{
+	return rte_ring_free_count(r) == 0;
+}
+
+/**
+ * 1 if the ring is empty, 0 otherwise.
+ */
+static inline int
+rte_ring_empty(const struct rte_ring *r)
+{
+	uint32_t prod_tail = r->prod.tail;
+	uint32_t cons_tail = r->cons.tail;
+
+	return cons_tail == prod_tail;
+}
+
+/**
+ * Size of the ring storage, in entries.
+ */
+static inline unsigned int
+rte_ring_get_size(const struct rte_ring *r)
+{
+	return r->size;
+}
+
+/**
+ * Max number of entries that can be stored in the ring.
+ */
+static inline unsigned int
+rte_ring_get_capacity(const struct rte_ring *r)
+{
+	return r->capacity;
+}
+
+ssize_t rte_ring_get_memsize_elem(unsigned int esize, unsigned int count);
+int rte_ring_init(struct rte_ring *r, unsigned int count, unsigned int flags);
+struct rte_ring *rte_ring_create_elem(unsigned int esize, unsigned int count,
+		unsigned int flags);
 struct rte_ring *rte_ring_create(unsigned int count, unsigned int flags);
 void rte_ring_free(struct rte_ring *r);
 
+/*
+ * Bulk calls move exactly n objects or none, burst calls move as many as
+ * possible up to n. They return the number of objects moved, and report
+ * the space left after an enqueue (free_space) or the objects left after
+ * a dequeue (available) when that pointer is not NULL.
+ *
+ * mp/mc calls are multi-thread safe, sp/sc calls assume a single producer
+ * or consumer, and the unprefixed calls use the mode the ring was created
+ * with. The _elem calls take objects of esize bytes (a multiple of 4, as
+ * given to rte_ring_create_elem()), the others take pointers.
+ */
+unsigned int rte_ring_mp_enqueue_bulk_elem(struct rte_ring *r,
+		const void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *free_space);
+unsigned int rte_ring_sp_enqueue_bulk_elem(struct rte_ring *r,
+		const void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *free_space);
+unsigned int rte_ring_enqueue_bulk_elem(struct rte_ring *r,
+		const void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *free_space);
+unsigned int rte_ring_mp_enqueue_burst_elem(struct rte_ring *r,
+		const void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *free_space);
+unsigned int rte_ring_sp_enqueue_burst_elem(struct rte_ring *r,
+		const void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *free_space);
+unsigned int rte_ring_enqueue_burst_elem(struct rte_ring *r,
+		const void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *free_space);
+
+unsigned int rte_ring_mc_dequeue_bulk_elem(struct rte_ring *r,
+		void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *available);
+unsigned int rte_ring_sc_dequeue_bulk_elem(struct rte_ring *r,
+		void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *available);
+unsigned int rte_ring_dequeue_bulk_elem(struct rte_ring *r,
+		void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *available);
+unsigned int rte_ring_mc_dequeue_burst_elem(struct rte_ring *r,
+		void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *available);
+unsigned int rte_ring_sc_dequeue_burst_elem(struct rte_ring *r,
+		void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *available);
+unsigned int rte_ring_dequeue_burst_elem(struct rte_ring *r,
+		void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *available);
+
+unsigned int rte_ring_mp_enqueue_bulk(struct rte_ring *r,
+		void * const *obj_table, unsigned int n, unsigned int *free_space);
+unsigned int rte_ring_sp_enqueue_bulk(struct rte_ring *r,
+		void * const *obj_table, unsigned int n, unsigned int *free_space);
+unsigned int rte_ring_enqueue_bulk(struct rte_ring *r,
+		void * const *obj_table, unsigned int n, unsigned int *free_space);
+unsigned int rte_ring_mp_enqueue_burst(struct rte_ring *r,
+		void * const *obj_table, unsigned int n, unsigned int *free_space);
+unsigned int rte_ring_sp_enqueue_burst(struct rte_ring *r,
+		void * const *obj_table, unsigned int n, unsigned int *free_space);
+unsigned int rte_ring_enqueue_burst(struct rte_ring *r,
+		void * const *obj_table, unsigned int n, unsigned int *free_space);
+
+unsigned int rte_ring_mc_dequeue_bulk(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available);
+unsigned int rte_ring_sc_dequeue_bulk(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available);
+unsigned int rte_ring_dequeue_bulk(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available);
+unsigned int rte_ring_mc_dequeue_burst(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available);
+unsigned int rte_ring_sc_dequeue_burst(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available);
+unsigned int rte_ring_dequeue_burst(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available);
+
+/*
+ * RTS mode calls, for rings created with RING_F_MP_RTS_ENQ and/or
+ * RING_F_MC_RTS_DEQ. The default mode calls dispatch to them as well.
+ */
+unsigned int rte_ring_mp_rts_enqueue_bulk_elem(struct rte_ring *r,
+		const void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *free_space);
+unsigned int rte_ring_mp_rts_enqueue_burst_elem(struct rte_ring *r,
+		const void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *free_space);
+unsigned int rte_ring_mc_rts_dequeue_bulk_elem(struct rte_ring *r,
+		void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *available);
+unsigned int rte_ring_mc_rts_dequeue_burst_elem(struct rte_ring *r,
+		void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *available);
+unsigned int rte_ring_mp_rts_enqueue_bulk(struct rte_ring *r,
+		void * const *obj_table, unsigned int n, unsigned int *free_space);
+unsigned int rte_ring_mp_rts_enqueue_burst(struct rte_ring *r,
+		void * const *obj_table, unsigned int n, unsigned int *free_space);
+unsigned int rte_ring_mc_rts_dequeue_bulk(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available);
+unsigned int rte_ring_mc_rts_dequeue_burst(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available);
+
+/*
+ * HTS mode calls, for rings created with RING_F_MP_HTS_ENQ and/or
+ * RING_F_MC_HTS_DEQ. The default mode calls dispatch to them as well.
+ */
+unsigned int rte_ring_mp_hts_enqueue_bulk_elem(struct rte_ring *r,
+		const void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *free_space);
+unsigned int rte_ring_mp_hts_enqueue_burst_elem(struct rte_ring *r,
+		const void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *free_space);
+unsigned int rte_ring_mc_hts_dequeue_bulk_elem(struct rte_ring *r,
+		void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *available);
+unsigned int rte_ring_mc_hts_dequeue_burst_elem(struct rte_ring *r,
+		void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *available);
+unsigned int rte_ring_mp_hts_enqueue_bulk(struct rte_ring *r,
+		void * const *obj_table, unsigned int n, unsigned int *free_space);
+unsigned int rte_ring_mp_hts_enqueue_burst(struct rte_ring *r,
+		void * const *obj_table, unsigned int n, unsigned int *free_space);
+unsigned int rte_ring_mc_hts_dequeue_bulk(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available);
+unsigned int rte_ring_mc_hts_dequeue_burst(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available);
+
+/*
+ * Zero-copy enqueue/dequeue, for ST and HTS producers/consumers only (0 is
+ * returned in the other modes). The _start calls reserve n slots like the
+ * bulk/burst calls and fill zcd with the ring storage of those slots, where
+ * the caller builds (enqueue) or reads (dequeue) the objects in place. The
+ * _finish call then publishes the first n of them; reserved slots beyond n
+ * are released. _finish must only follow a _start that returned non-zero,
+ * and the thread must not start another enqueue (dequeue) in between.
+ */
+unsigned int rte_ring_enqueue_zc_bulk_elem_start(struct rte_ring *r,
+		unsigned int esize, unsigned int n, struct rte_ring_zc_data *zcd,
+		unsigned int *free_space);
+unsigned int rte_ring_enqueue_zc_burst_elem_start(struct rte_ring *r,
+		unsigned int esize, unsigned int n, struct rte_ring_zc_data *zcd,
+		unsigned int *free_space);
+void rte_ring_enqueue_zc_elem_finish(struct rte_ring *r, unsigned int n);
+unsigned int rte_ring_enqueue_zc_bulk_start(struct rte_ring *r,
+		unsigned int n, struct rte_ring_zc_data *zcd,
+		unsigned int *free_space);
+unsigned int rte_ring_enqueue_zc_burst_start(struct rte_ring *r,
+		unsigned int n, struct rte_ring_zc_data *zcd,
+		unsigned int *free_space);
+void rte_ring_enqueue_zc_finish(struct rte_ring *r, unsigned int n);
+
+unsigned int rte_ring_dequeue_zc_bulk_elem_start(struct rte_ring *r,
+		unsigned int esize, unsigned int n, struct rte_ring_zc_data *zcd,
+		unsigned int *available);
+unsigned int rte_ring_dequeue_zc_burst_elem_start(struct rte_ring *r,
+		unsigned int esize, unsigned int n, struct rte_ring_zc_data *zcd,
+		unsigned int *available);
+void rte_ring_dequeue_zc_elem_finish(struct rte_ring *r, unsigned int n);
+unsigned int rte_ring_dequeue_zc_bulk_start(struct rte_ring *r,
+		unsigned int n, struct rte_ring_zc_data *zcd,
+		unsigned int *available);
+unsigned int rte_ring_dequeue_zc_burst_start(struct rte_ring *r,
+		unsigned int n, struct rte_ring_zc_data *zcd,
+		unsigned int *available);
+void rte_ring_dequeue_zc_finish(struct rte_ring *r, unsigned int n);
+
+/*
+ * Peek API, for ST and HTS producers/consumers only (0 is returned in the
+ * other modes). rte_ring_dequeue_*_start copies up to n objects out like
+ * the bulk/burst calls, but leaves them in the ring until
+ * rte_ring_dequeue_*finish(r, n) commits the first n of them; the others
+ * stay at the head of the ring, in order. rte_ring_enqueue_*_start reserves
+ * n slots and rte_ring_enqueue_*finish copies the first n objects of
+ * obj_table into them and publishes them. The same rules as the zero-copy
+ * API apply between _start and _finish.
+ */
+unsigned int rte_ring_enqueue_bulk_elem_start(struct rte_ring *r,
+		unsigned int n, unsigned int *free_space);
+unsigned int rte_ring_enqueue_burst_elem_start(struct rte_ring *r,
+		unsigned int n, unsigned int *free_space);
+void rte_ring_enqueue_elem_finish(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n);
+unsigned int rte_ring_enqueue_bulk_start(struct rte_ring *r, unsigned int n,
+		unsigned int *free_space);
+unsigned int rte_ring_enqueue_burst_start(struct rte_ring *r, unsigned int n,
+		unsigned int *free_space);
+void rte_ring_enqueue_finish(struct rte_ring *r, void * const *obj_table,
+		unsigned int n);
+
+unsigned int rte_ring_dequeue_bulk_elem_start(struct rte_ring *r,
+		void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *available);
+unsigned int rte_ring_dequeue_burst_elem_start(struct rte_ring *r,
+		void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *available);
+void rte_ring_dequeue_elem_finish(struct rte_ring *r, unsigned int n);
+unsigned int rte_ring_dequeue_bulk_start(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available);
+unsigned int rte_ring_dequeue_burst_start(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available);
+void rte_ring_dequeue_finish(struct rte_ring *r, unsigned int n);
+
+/*
+ * Head/tail distance limit of an RTS producer or consumer, capacity / 8 by
+ * default. The setters return -ENOTSUP if that side is not in RTS mode and
+ * -EINVAL if v exceeds the ring capacity; the getters return -ENOTSUP.
+ */
+int rte_ring_set_prod_htd_max(struct rte_ring *r, uint32_t v);
+int rte_ring_get_prod_htd_max(const struct rte_ring *r);
+int rte_ring_set_cons_htd_max(struct rte_ring *r, uint32_t v);
+int rte_ring_get_cons_htd_max(const struct rte_ring *r);
+
+/*
+ * Sum the per thread counters of the ring into stats; -ENOTSUP when ring.c
+ * was built without RTE_RING_STATS. Reset clears them; counts made by
+ * threads running at the same time may survive the reset.
+ */
+int rte_ring_stats_get(const struct rte_ring *r, struct rte_ring_stats *stats);
+void rte_ring_stats_reset(struct rte_ring *r);
+
+/* Single object calls: 0 on success, -ENOBUFS/-ENOENT otherwise. */
+int rte_ring_enqueue_elem(struct rte_ring *r, void *obj, unsigned int esize);
+int rte_ring_dequeue_elem(struct rte_ring *r, void *obj_p, unsigned int esize);
+int rte_ring_enqueue(struct rte_ring *r, void *obj);
+int rte_ring_dequeue(struct rte_ring *r, void **obj_p);
+
+/*
+ * Blocking dequeue. An empty ring is polled RTE_RING_WAIT_SPINS times, then
+ * the caller sleeps until a producer publishes new objects (rings created
+ * with RING_F_DEQ_WAIT) or keeps polling (other rings). Producers only enter
+ * the kernel when a consumer is asleep, so a busy ring costs no syscalls.
+ * The burst calls return at least one object, or 0 once timeout_ns has
+ * elapsed; the single object calls return 0 or -ETIMEDOUT.
+ */
+#ifndef RTE_RING_WAIT_SPINS
+#define RTE_RING_WAIT_SPINS 1024
+#endif
+
+unsigned int rte_ring_dequeue_burst_elem_wait(struct rte_ring *r,
+		void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *available);
+unsigned int rte_ring_dequeue_burst_elem_timedwait(struct rte_ring *r,
+		void *obj_table, unsigned int esize, unsigned int n,
+		unsigned int *available, uint64_t timeout_ns);
+unsigned int rte_ring_dequeue_burst_wait(struct rte_ring *r, void **obj_table,
+		unsigned int n, unsigned int *available);
+unsigned int rte_ring_dequeue_burst_timedwait(struct rte_ring *r,
+		void **obj_table, unsigned int n, unsigned int *available,
+		uint64_t timeout_ns);
+int rte_ring_dequeue_wait(struct rte_ring *r, void **obj_p);
+int rte_ring_dequeue_timedwait(struct rte_ring *r, void **obj_p,
+		uint64_t timeout_ns);
+
 #endif
@@ -0,0 +1,404 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "ring.h"
+
+/*
+ * Ring throughput and latency benchmark.
+ *
+ *   ring_perf [-n elements per test] [-r round trips] [-p cpu,cpu]
+ *
+ * For every sync mode (SP/SC, MP/MC, RTS, HTS), element size (4, 8, 16,
+ * 32 bytes) and bulk size (1..256) it reports the cycles per element of
+ * an enqueue/dequeue loop on one thread, then of a producer/consumer pair
+ * on two hyperthreads of one core, two cores of one socket and two
+ * sockets, as found in sysfs (-p runs an explicit pair instead). Every
+ * pair also gets a single element round trip latency histogram.
+ */
+
+#define MAX_BULK        256
+#define MAX_ESIZE       32
+#define RING_SIZE       4096
+#define HIST_BUCKETS    32
+
+struct sync_mode {
+	const char *name;
+	unsigned int flags;
+};
+
+static const struct sync_mode modes[] = {
+	{ "sp/sc", RING_F_SP_ENQ | RING_F_SC_DEQ },
+	{ "mp/mc", 0 },
+	{ "rts", RING_F_MP_RTS_ENQ | RING_F_MC_RTS_DEQ },
+	{ "hts", RING_F_MP_HTS_ENQ | RING_F_MC_HTS_DEQ },
+};
+
+static const unsigned int esizes[] = { 4, 8, 16, 32 };
+static const unsigned int bulks[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256 };
+
+struct cpu_pair {
+	const char *name;
+	int cpu[2];
+};
+
+struct pair_arg {
+	struct rte_ring *r;
+	struct rte_ring *r2;    /**< return ring of the round trip test */
+	int cpu;
+	unsigned int esize;
+	unsigned int bulk;
+	uint64_t cycles;
+	uint64_t hist[HIST_BUCKETS];
+};
+
+static uint64_t nb_elems = 1 << 22;
+static uint64_t nb_rtt = 1 << 16;
+static volatile int go;
+
+static inline uint64_t
+rte_rdtsc(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+static int
+read_topology(int cpu, const char *name)
+{
+	char path[128];
+	FILE *f;
+	int v = -1;
+
+	snprintf(path, sizeof(path),
+		"/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+	f = fopen(path, "r");
+	if (f == NULL)
+		return -1;
+	if (fscanf(f, "%d", &v) != 1)
+		v = -1;
+	fclose(f);
+	return v;
+}
+
+/*
+ * Finds a pair of cpus for each of the hyperthread, core and socket
+ * topologies; missing ones are left at -1.
+ */
+static void
+find_pairs(struct cpu_pair *pairs)
+{
+	long nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int a, b, core_a, core_b, pkg_a, pkg_b, i;
+
+	for (i = 0; i < 3; i++)
+		pairs[i].cpu[0] = pairs[i].cpu[1] = -1;
+
+	for (a = 0; a < nb_cpus; a++) {
+		core_a = read_topology(a, "core_id");
+		pkg_a = read_topology(a, "physical_package_id");
+		for (b = a + 1; b < nb_cpus; b++) {
+			core_b = read_topology(b, "core_id");
+			pkg_b = read_topology(b, "physical_package_id");
+
+			if (pkg_a != pkg_b)
+				i = 2;
+			else if (core_a == core_b)
+				i = 0;
+			else
+				i = 1;
+
+			if (pairs[i].cpu[0] < 0) {
+				pairs[i].cpu[0] = a;
+				pairs[i].cpu[1] = b;
+			}
+		}
+	}
+}
+
+static void
+pin(int cpu)
+{
+	cpu_set_t set;
+
+	if (cpu < 0)
+		return;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/* enqueue and dequeue on the same thread */
+static double
+test_single(struct rte_ring *r, unsigned int esize, unsigned int bulk)
+{
+	uint8_t objs[MAX_BULK * MAX_ESIZE] = {0};
+	uint64_t i, iters = nb_elems / bulk, t0;
+
+	t0 = rte_rdtsc();
+	for (i = 0; i < iters; i++) {
+		rte_ring_enqueue_bulk_elem(r, objs, esize, bulk, NULL);
+		rte_ring_dequeue_bulk_elem(r, objs, esize, bulk, NULL);
+	}
+
+	return (double)(rte_rdtsc() - t0) / (iters * bulk);
+}
+
+static void *
+producer(void *p)
+{
+	struct pair_arg *arg = p;
+	uint8_t objs[MAX_BULK * MAX_ESIZE] = {0};
+	uint64_t i, iters = nb_elems / arg->bulk, t0;
+
+	pin(arg->cpu);
+	while (!go)
+		;
+
+	t0 = rte_rdtsc();
+	for (i = 0; i < iters; i++)
+		while (rte_ring_enqueue_bulk_elem(arg->r, objs, arg->esize,
+				arg->bulk, NULL) == 0)
+			rte_pause();
+	arg->cycles = rte_rdtsc() - t0;
+
+	return NULL;
+}
+
+static void *
+consumer(void *p)
+{
+	struct pair_arg *arg = p;
+	uint8_t objs[MAX_BULK * MAX_ESIZE];
+	uint64_t i, iters = nb_elems / arg->bulk, t0;
+
+	pin(arg->cpu);
+	while (!go)
+		;
+
+	t0 = rte_rdtsc();
+	for (i = 0; i < iters; i++)
+		while (rte_ring_dequeue_bulk_elem(arg->r, objs, arg->esize,
+				arg->bulk, NULL) == 0)
+			rte_pause();
+	arg->cycles = rte_rdtsc() - t0;
+
+	return NULL;
+}
+
+/* producer and consumer on the two cpus of a pair */
+static void
+test_pair(struct rte_ring *r, const struct cpu_pair *pair,
+		unsigned int esize, unsigned int bulk,
+		double *enq_cycles, double *deq_cycles)
+{
+	struct pair_arg args[2];
+	pthread_t threads[2];
+
+	memset(args, 0, sizeof(args));
+	args[0].r = args[1].r = r;
+	args[0].esize = args[1].esize = esize;
+	args[0].bulk = args[1].bulk = bulk;
+	args[0].cpu = pair->cpu[0];
+	args[1].cpu = pair->cpu[1];
+
+	go = 0;
+	pthread_create(&threads[0], NULL, producer, &args[0]);
+	pthread_create(&threads[1], NULL, consumer, &args[1]);
+	go = 1;
+	pthread_join(threads[0], NULL);
+	pthread_join(threads[1], NULL);
+
+	*enq_cycles = (double)args[0].cycles / (nb_elems / bulk * bulk);
+	*deq_cycles = (double)args[1].cycles / (nb_elems / bulk * bulk);
+}
+
+/* sends one element at a time and waits for it to come back */
+static void *
+rtt_ping(void *p)
+{
+	struct pair_arg *arg = p;
+	uint64_t i, t0, obj = 0;
+	unsigned int bucket;
+
+	pin(arg->cpu);
+	while (!go)
+		;
+
+	for (i = 0; i < nb_rtt; i++) {
+		t0 = rte_rdtsc();
+		while (rte_ring_enqueue_bulk_elem(arg->r, &obj, 8, 1, NULL) == 0)
+			rte_pause();
+		while (rte_ring_dequeue_bulk_elem(arg->r2, &obj, 8, 1, NULL) == 0)
+			rte_pause();
+		t0 = rte_rdtsc() - t0;
+
+		bucket = 0;
+		while (t0 > 1 && bucket < HIST_BUCKETS - 1) {
+			t0 >>= 1;
+			bucket++;
+		}
+		arg->hist[bucket]++;
+	}
+
+	return NULL;
+}
+
+static void *
+rtt_pong(void *p)
+{
+	struct pair_arg *arg = p;
+	uint64_t i, obj;
+
+	pin(arg->cpu);
+	while (!go)
+		;
+
+	for (i = 0; i < nb_rtt; i++) {
+		while (rte_ring_dequeue_bulk_elem(arg->r, &obj, 8, 1, NULL) == 0)
+			rte_pause();
+		while (rte_ring_enqueue_bulk_elem(arg->r2, &obj, 8, 1, NULL) == 0)
+			rte_pause();
+	}
+
+	return NULL;
+}
+
+static void
+test_rtt(const struct sync_mode *mode, const struct cpu_pair *pair)
+{
+	struct pair_arg args[2];
+	pthread_t threads[2];
+	uint64_t seen = 0;
+	unsigned int i;
+
+	memset(args, 0, sizeof(args));
+	args[0].r = args[1].r = rte_ring_create_elem(8, RING_SIZE, mode->flags);
+	args[0].r2 = args[1].r2 = rte_ring_create_elem(8, RING_SIZE,
+			mode->flags);
+	args[0].cpu = pair->cpu[0];
+	args[1].cpu = pair->cpu[1];
+	if (args[0].r == NULL || args[0].r2 == NULL)
+		return;
+
+	go = 0;
+	pthread_create(&threads[0], NULL, rtt_ping, &args[0]);
+	pthread_create(&threads[1], NULL, rtt_pong, &args[1]);
+	go = 1;
+	pthread_join(threads[0], NULL);
+	pthread_join(threads[1], NULL);
+
+	printf("%s %s round trip cycles (%lu samples):\n", mode->name,
+		pair->name, (unsigned long)nb_rtt);
+	for (i = 0; i < HIST_BUCKETS; i++) {
+		if (args[0].hist[i] == 0)
+			continue;
+		seen += args[0].hist[i];
+		printf("  < %-12llu %10lu  %6.2f%%\n", 2ULL << i,
+			(unsigned long)args[0].hist[i], 100.0 * seen / nb_rtt);
+	}
+
+	rte_ring_free(args[0].r);
+	rte_ring_free(args[0].r2);
+}
+
+int main(int argc, char *argv[])
+{
+	struct cpu_pair pairs[3] = {
+		{ "hyperthreads", { -1, -1 } },
+		{ "cores", { -1, -1 } },
+		{ "sockets", { -1, -1 } },
+	};
+	unsigned int m, e, b, p, nb_pairs = 3;
+	double enq, deq;
+	struct rte_ring *r;
+	int opt;
+
+	find_pairs(pairs);
+
+	while ((opt = getopt(argc, argv, "n:r:p:")) != -1) {
+		switch (opt) {
+		case 'n':
+			nb_elems = strtoull(optarg, NULL, 0);
+			break;
+		case 'r':
+			nb_rtt = strtoull(optarg, NULL, 0);
+			break;
+		case 'p':
+			pairs[0].name = "pair";
+			if (sscanf(optarg, "%d,%d", &pairs[0].cpu[0],
+					&pairs[0].cpu[1]) != 2)
+				return -1;
+			nb_pairs = 1;
+			break;
+		default:
+			printf("usage: %s [-n elements per test] "
+				"[-r round trips] [-p cpu,cpu]\n", argv[0]);
+			return -1;
+		}
+	}
+
+	if (nb_elems < MAX_BULK) {
+		printf("Need at least %d elements per test\n", MAX_BULK);
+		return -1;
+	}
+
+	for (p = 0; p < nb_pairs; p++) {
+		if (pairs[p].cpu[0] < 0)
+			printf("no %s pair found, skipping\n", pairs[p].name);
+		else
+			printf("%s: cpu %d and cpu %d\n", pairs[p].name,
+				pairs[p].cpu[0], pairs[p].cpu[1]);
+	}
+
+	printf("%-6s %5s %5s %12s", "mode", "esize", "bulk", "single");
+	for (p = 0; p < nb_pairs; p++)
+		if (pairs[p].cpu[0] >= 0)
+			printf(" %13s-enq %13s-deq", pairs[p].name, pairs[p].name);
+	printf("\n");
+
+	for (m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+		for (e = 0; e < sizeof(esizes) / sizeof(esizes[0]); e++) {
+			r = rte_ring_create_elem(esizes[e], RING_SIZE,
+					modes[m].flags);
+			if (r == NULL)
+				return -1;
+
+			for (b = 0; b < sizeof(bulks) / sizeof(bulks[0]); b++) {
+				printf("%-6s %5u %5u %12.2f", modes[m].name,
+					esizes[e], bulks[b],
+					test_single(r, esizes[e], bulks[b]));
+				for (p = 0; p < nb_pairs; p++) {
+					if (pairs[p].cpu[0] < 0)
+						continue;
+					test_pair(r, &pairs[p], esizes[e],
+						bulks[b], &enq, &deq);
+					printf(" %17.2f %17.2f", enq, deq);
+				}
+				printf("\n");
+				fflush(stdout);
+			}
+
+			rte_ring_free(r);
+		}
+	}
+
+	for (m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+		for (p = 0; p < nb_pairs; p++)
+			if (pairs[p].cpu[0] >= 0)
+				test_rtt(&modes[m], &pairs[p]);
+
+	return 0;
+}
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ring.h"
+
+/*
+ * Over-subscribed ring benchmark: runs more producer and consumer threads
+ * than there are cores, so threads get preempted between moving the head
+ * and updating the tail, and compares MP/MC against RTS and HTS modes.
+ *
+ *   ring_rts_perf [-t threads per core] [-b burst] [-d seconds]
+ *                 [-s ring size] [-m htd_max]
+ */
+
+#define MAX_BURST 256
+
+struct worker {
+	pthread_t thread;
+	struct rte_ring *r;
+	int producer;
+	uint64_t objs;
+};
+
+static unsigned int burst = 32;
+static volatile int start;
+static volatile int stop;
+
+static void *
+worker_loop(void *arg)
+{
+	struct worker *w = arg;
+	void *objs[MAX_BURST];
+	unsigned int i;
+
+	for (i = 0; i < burst; i++)
+		objs[i] = (void *)(uintptr_t)(i + 1);
+
+	while (!start)
+		;
+
+	while (!stop) {
+		if (w->producer)
+			w->objs += rte_ring_enqueue_burst(w->r, objs, burst, NULL);
+		else
+			w->objs += rte_ring_dequeue_burst(w->r, objs, burst, NULL);
+	}
+
+	return NULL;
+}
+
+static int
+run(const char *name, unsigned int flags, unsigned int size,
+		unsigned int nb_threads, unsigned int duration, int htd_max)
+{
+	struct worker *workers;
+	struct rte_ring *r;
+	struct timespec t0, t1;
+	uint64_t enq = 0, deq = 0;
+	double elapsed;
+	unsigned int i;
+
+	r = rte_ring_create(size, flags);
+	workers = calloc(nb_threads, sizeof(*workers));
+	if (r == NULL || workers == NULL) {
+		printf("Cannot create ring\n");
+		return -1;
+	}
+
+	if (htd_max >= 0 && (flags & RING_F_MP_RTS_ENQ)) {
+		rte_ring_set_prod_htd_max(r, htd_max);
+		rte_ring_set_cons_htd_max(r, htd_max);
+	}
+
+	start = 0;
+	stop = 0;
+	for (i = 0; i < nb_threads; i++) {
+		workers[i].r = r;
+		workers[i].producer = i & 1;
+		pthread_create(&workers[i].thread, NULL, worker_loop, &workers[i]);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	start = 1;
+	sleep(duration);
+	stop = 1;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nb_threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+		if (workers[i].producer)
+			enq += workers[i].objs;
+		else
+			deq += workers[i].objs;
+	}
+
+	elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	printf("%-6s threads:%u burst:%u enq:%.2f Mobj/s deq:%.2f Mobj/s\n",
+		name, nb_threads, burst, enq / elapsed / 1e6,
+		deq / elapsed / 1e6);
+
+	free(workers);
+	rte_ring_free(r);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int per_core = 4, duration = 3, size = 1024;
+	unsigned int nb_threads;
+	long nb_cores;
+	int htd_max = -1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:b:d:s:m:")) != -1) {
+		switch (opt) {
+		case 't':
+			per_core = atoi(optarg);
+			break;
+		case 'b':
+			burst = atoi(optarg);
+			break;
+		case 'd':
+			duration = atoi(optarg);
+			break;
+		case 's':
+			size = atoi(optarg);
+			break;
+		case 'm':
+			htd_max = atoi(optarg);
+			break;
+		default:
+			printf("usage: %s [-t threads per core] [-b burst] "
+				"[-d seconds] [-s ring size] [-m htd_max]\n",
+				argv[0]);
+			return -1;
+		}
+	}
+
+	if (burst == 0 || burst > MAX_BURST || per_core == 0) {
+		printf("Invalid burst size or thread count\n");
+		return -1;
+	}
+
+	nb_cores = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nb_cores < 1)
+		nb_cores = 1;
+
+	/* at least one producer and one consumer */
+	nb_threads = nb_cores * per_core;
+	if (nb_threads < 2)
+		nb_threads = 2;
+
+	printf("cores:%ld\n", nb_cores);
+	run("mp/mc", 0, size, nb_threads, duration, htd_max);
+	run("rts", RING_F_MP_RTS_ENQ | RING_F_MC_RTS_DEQ, size, nb_threads,
+		duration, htd_max);
+	run("hts", RING_F_MP_HTS_ENQ | RING_F_MC_HTS_DEQ, size, nb_threads,
+		duration, htd_max);
+
+	return 0;
+}
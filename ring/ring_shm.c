@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ring_shm.h"
+
+#define RING_SHM_HDR_SIZE \
+	RTE_ALIGN(sizeof(struct rte_ring_shm_hdr), RTE_CACHE_LINE_SIZE)
+
+static inline struct rte_ring_shm_hdr *
+__rte_ring_shm_hdr(struct rte_ring *r)
+{
+	return (struct rte_ring_shm_hdr *)((uint8_t *)r - RING_SHM_HDR_SIZE);
+}
+
+static inline struct rte_ring *
+__rte_ring_shm_ring(struct rte_ring_shm_hdr *h)
+{
+	return (struct rte_ring *)((uint8_t *)h + RING_SHM_HDR_SIZE);
+}
+
+static int
+__rte_ring_shm_register(struct rte_ring_shm_hdr *h, unsigned int role)
+{
+	union rte_ring_shm_peer self, free_slot;
+	unsigned int i;
+
+	self.val.pid = getpid();
+	self.val.role = role;
+	for (i = 0; i < RTE_RING_SHM_MAX_PEERS; i++) {
+		free_slot.raw = 0;
+		if (__atomic_compare_exchange_n(&h->peers[i].raw,
+				&free_slot.raw, self.raw, 0, __ATOMIC_ACQ_REL,
+				__ATOMIC_RELAXED))
+			return 0;
+	}
+
+	printf("Too many processes attached to the ring\n");
+	return -ENOSPC;
+}
+
+/* pid alive, or at least present but owned by someone else */
+static int
+__rte_ring_shm_pid_alive(int32_t pid)
+{
+	return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+
+ssize_t
+rte_ring_shm_get_memsize(unsigned int esize, unsigned int count,
+		unsigned int flags)
+{
+	ssize_t sz;
+
+	/* for an exact size ring, round up from count to a power of two */
+	if (flags & RING_F_EXACT_SZ)
+		count = rte_align32pow2(count + 1);
+
+	sz = rte_ring_get_memsize_elem(esize, count);
+	if (sz < 0)
+		return sz;
+	return RING_SHM_HDR_SIZE + sz;
+}
+
+
+struct rte_ring *
+rte_ring_shm_create_fd(int fd, unsigned int esize, unsigned int count,
+		unsigned int flags, unsigned int role)
+{
+	struct rte_ring_shm_hdr *h;
+	struct rte_ring *r;
+	ssize_t size;
+
+	size = rte_ring_shm_get_memsize(esize, count, flags);
+	if (size < 0)
+		return NULL;
+
+	if (ftruncate(fd, size) != 0) {
+		printf("Cannot size shared memory: %s\n", strerror(errno));
+		return NULL;
+	}
+
+	h = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (h == MAP_FAILED) {
+		printf("Cannot map shared memory: %s\n", strerror(errno));
+		return NULL;
+	}
+
+	memset(h, 0, RING_SHM_HDR_SIZE);
+	h->map_size = size;
+	h->ring_size = sizeof(struct rte_ring);
+	h->esize = esize;
+
+	r = __rte_ring_shm_ring(h);
+	if (rte_ring_init(r, count, flags) != 0 ||
+			__rte_ring_shm_register(h, role) != 0) {
+		munmap(h, size);
+		return NULL;
+	}
+
+	/* attach only accepts the ring once everything above is visible */
+	__atomic_store_n(&h->magic, RTE_RING_SHM_MAGIC, __ATOMIC_RELEASE);
+	return r;
+}
+
+struct rte_ring *
+rte_ring_shm_create(const char *name, unsigned int esize, unsigned int count,
+		unsigned int flags, unsigned int role)
+{
+	struct rte_ring *r;
+	int fd;
+
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd < 0) {
+		printf("Cannot create shared memory %s: %s\n", name,
+			strerror(errno));
+		return NULL;
+	}
+
+	r = rte_ring_shm_create_fd(fd, esize, count, flags, role);
+	close(fd);
+	if (r == NULL)
+		shm_unlink(name);
+	return r;
+}
+
+
+struct rte_ring *
+rte_ring_shm_attach_fd(int fd, unsigned int role)
+{
+	struct rte_ring_shm_hdr *h;
+	struct stat st;
+	uint64_t size;
+
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < RING_SHM_HDR_SIZE) {
+		printf("Shared memory holds no ring\n");
+		return NULL;
+	}
+	size = st.st_size;
+
+	h = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (h == MAP_FAILED) {
+		printf("Cannot map shared memory: %s\n", strerror(errno));
+		return NULL;
+	}
+
+	if (__atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) != RTE_RING_SHM_MAGIC ||
+			h->map_size != size) {
+		printf("Shared memory holds no ring\n");
+		goto fail;
+	}
+	if (h->ring_size != sizeof(struct rte_ring)) {
+		printf("Ring layout mismatch, check RTE_RING_STATS\n");
+		goto fail;
+	}
+	if (__rte_ring_shm_register(h, role) != 0)
+		goto fail;
+
+	return __rte_ring_shm_ring(h);
+
+fail:
+	munmap(h, size);
+	return NULL;
+}
+
+struct rte_ring *
+rte_ring_shm_attach(const char *name, unsigned int role)
+{
+	struct rte_ring *r;
+	int fd;
+
+	fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0) {
+		printf("Cannot open shared memory %s: %s\n", name,
+			strerror(errno));
+		return NULL;
+	}
+
+	r = rte_ring_shm_attach_fd(fd, role);
+	close(fd);
+	return r;
+}
+
+
+void
+rte_ring_shm_detach(struct rte_ring *r)
+{
+	struct rte_ring_shm_hdr *h;
+	int32_t pid = getpid();
+	unsigned int i;
+
+	if (r == NULL)
+		return;
+
+	h = __rte_ring_shm_hdr(r);
+	for (i = 0; i < RTE_RING_SHM_MAX_PEERS; i++)
+		if (h->peers[i].val.pid == pid) {
+			__atomic_store_n(&h->peers[i].raw, 0, __ATOMIC_RELEASE);
+			break;
+		}
+
+	munmap(h, h->map_size);
+}
+
+int
+rte_ring_shm_unlink(const char *name)
+{
+	return shm_unlink(name) == 0 ? 0 : -errno;
+}
+
+
+unsigned int
+rte_ring_shm_peers_alive(struct rte_ring *r, unsigned int role)
+{
+	struct rte_ring_shm_hdr *h = __rte_ring_shm_hdr(r);
+	union rte_ring_shm_peer p;
+	int32_t self = getpid();
+	unsigned int i, alive = 0;
+
+	for (i = 0; i < RTE_RING_SHM_MAX_PEERS; i++) {
+		p.raw = __atomic_load_n(&h->peers[i].raw, __ATOMIC_ACQUIRE);
+		if (p.val.pid == 0 || p.val.pid == self ||
+				!(p.val.role & role))
+			continue;
+
+		if (__rte_ring_shm_pid_alive(p.val.pid))
+			alive++;
+		else
+			/* exited without detaching, free its slot */
+			__atomic_compare_exchange_n(&h->peers[i].raw, &p.raw,
+					0, 0, __ATOMIC_ACQ_REL,
+					__ATOMIC_RELAXED);
+	}
+
+	return alive;
+}
@@ -0,0 +1,83 @@
+#ifndef RING_SHM_H_
+#define RING_SHM_H_
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "ring.h"
+
+/*
+ * Rings shared between processes. The ring, header and element storage as
+ * sized by rte_ring_get_memsize_elem(), is placed in a shared mapping
+ * behind a small header. struct rte_ring holds no pointers and locates its
+ * storage with &r[1], so every process can map it at any address. Objects
+ * are copied into the ring by value: pass offsets or handles, not
+ * pointers, and use the zero-copy API to build objects in place. Blocking
+ * dequeue (RING_F_DEQ_WAIT) works across processes as well.
+ *
+ * The region is either a POSIX shm object (rte_ring_shm_create/attach by
+ * name) or any file descriptor the caller set up, e.g. with memfd_create()
+ * and passed on over a unix socket or by fork (the _fd calls).
+ *
+ * Every process that maps the ring registers its pid with its role, and
+ * rte_ring_shm_peers_alive() finds the peers of a role that have exited.
+ * All processes must be built with the same RTE_RING_STATS setting; attach
+ * checks the layout.
+ */
+
+#define RTE_RING_SHM_PROD 0x1 /**< Process enqueues. */
+#define RTE_RING_SHM_CONS 0x2 /**< Process dequeues. */
+
+#define RTE_RING_SHM_MAX_PEERS 16
+
+#define RTE_RING_SHM_MAGIC 0x52494e47534d3031ULL /* "RINGSM01" */
+
+/** pid and role are claimed together with one 64 bit CAS. */
+union rte_ring_shm_peer {
+	uint64_t raw;
+	struct {
+		int32_t pid;     /**< 0 when the slot is free */
+		uint32_t role;   /**< RTE_RING_SHM_PROD/CONS */
+	} val;
+};
+
+/** Start of the mapping, the ring follows on the next cache line. */
+struct rte_ring_shm_hdr {
+	volatile uint64_t magic; /**< set once the ring is initialized */
+	uint64_t map_size;       /**< size of the whole mapping */
+	uint32_t ring_size;      /**< sizeof(struct rte_ring) of the creator */
+	uint32_t esize;          /**< element size */
+	volatile union rte_ring_shm_peer peers[RTE_RING_SHM_MAX_PEERS];
+} __rte_cache_aligned;
+
+ssize_t rte_ring_shm_get_memsize(unsigned int esize, unsigned int count,
+		unsigned int flags);
+
+/*
+ * Create the shm object name (see shm_open(3)), which must not exist yet,
+ * or build the ring in fd, which is resized to fit. The caller is
+ * registered with role. Return NULL on error.
+ */
+struct rte_ring *rte_ring_shm_create(const char *name, unsigned int esize,
+		unsigned int count, unsigned int flags, unsigned int role);
+struct rte_ring *rte_ring_shm_create_fd(int fd, unsigned int esize,
+		unsigned int count, unsigned int flags, unsigned int role);
+
+/* Map an existing ring and register the caller with role. */
+struct rte_ring *rte_ring_shm_attach(const char *name, unsigned int role);
+struct rte_ring *rte_ring_shm_attach_fd(int fd, unsigned int role);
+
+/* Unregister the caller and unmap the ring; the ring stays for the others. */
+void rte_ring_shm_detach(struct rte_ring *r);
+
+/* Remove the shm object name, mapped rings stay usable until detached. */
+int rte_ring_shm_unlink(const char *name);
+
+/*
+ * Number of other processes registered with a role in role that are still
+ * alive. Slots of processes that exited without detaching are released.
+ * Liveness comes from kill(pid, 0): a zombie not yet reaped by its parent
+ * still counts as alive, and a recycled pid looks like the old peer.
+ */
+unsigned int rte_ring_shm_peers_alive(struct rte_ring *r, unsigned int role);
+
+#endif
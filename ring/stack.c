@@ -0,0 +1,300 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#include "stack.h"
+
+#if defined(__x86_64__)
+
+/* 128-bit compare and swap, exp is updated with the current value on failure */
+static inline int
+rte_atomic128_cmp_exchange(struct rte_stack_lf_head *dst,
+		struct rte_stack_lf_head *exp, const struct rte_stack_lf_head *src)
+{
+	uint64_t lo = (uint64_t)(uintptr_t)exp->top, hi = exp->cnt;
+	uint8_t res;
+
+	asm volatile(
+			MPLOCKED
+			"cmpxchg16b %[dst];"
+			"sete %[res];"
+			: [dst] "+m" (*dst),
+			  [res] "=q" (res),
+			  "+a" (lo),
+			  "+d" (hi)
+			: "b" ((uint64_t)(uintptr_t)src->top),
+			  "c" (src->cnt)
+			: "memory", "cc");
+	if (!res) {
+		exp->top = (struct rte_stack_lf_elem *)(uintptr_t)lo;
+		exp->cnt = hi;
+	}
+	return res;
+}
+
+#else
+
+static inline int
+rte_atomic128_cmp_exchange(struct rte_stack_lf_head *dst,
+		struct rte_stack_lf_head *exp, const struct rte_stack_lf_head *src)
+{
+	return __atomic_compare_exchange(dst, exp,
+			(struct rte_stack_lf_head *)src, 0,
+			__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+#endif
+
+static inline void
+rte_stack_lf_read_head(const struct rte_stack_lf_list *list,
+		struct rte_stack_lf_head *head)
+{
+	/* a torn read only makes the following CAS fail */
+	head->cnt = __atomic_load_n(&list->head.cnt, __ATOMIC_ACQUIRE);
+	head->top = __atomic_load_n(&list->head.top, __ATOMIC_RELAXED);
+}
+
+/* link the chain first..last of n elements on top of the list */
+static void
+__rte_stack_lf_push_elems(struct rte_stack_lf_list *list,
+		struct rte_stack_lf_elem *first, struct rte_stack_lf_elem *last,
+		unsigned int n)
+{
+	struct rte_stack_lf_head old_head, new_head;
+
+	rte_stack_lf_read_head(list, &old_head);
+	do {
+		last->next = old_head.top;
+		new_head.top = first;
+		new_head.cnt = old_head.cnt + 1;
+	} while (!rte_atomic128_cmp_exchange(&list->head, &old_head,
+			&new_head));
+
+	__atomic_add_fetch(&list->len, n, __ATOMIC_RELEASE);
+}
+
+/*
+ * Unlink the top n elements, storing their objects in obj_table unless it
+ * is NULL. Returns the first element and sets *last, or returns NULL if the
+ * list holds fewer than n elements.
+ */
+static struct rte_stack_lf_elem *
+__rte_stack_lf_pop_elems(struct rte_stack_lf_list *list, unsigned int n,
+		void **obj_table, struct rte_stack_lf_elem **last)
+{
+	struct rte_stack_lf_head old_head, new_head;
+	struct rte_stack_lf_elem *tmp;
+	uint64_t len;
+	unsigned int i;
+
+	/* reserve n elements so the walk below always finds them */
+	len = __atomic_load_n(&list->len, __ATOMIC_ACQUIRE);
+	do {
+		if (len < n)
+			return NULL;
+	} while (!__atomic_compare_exchange_n(&list->len, &len, len - n, 0,
+			__ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+	rte_stack_lf_read_head(list, &old_head);
+	for (;;) {
+		tmp = old_head.top;
+		for (i = 0; i < n && tmp != NULL; i++) {
+			if (obj_table != NULL)
+				obj_table[i] = tmp->data;
+			*last = tmp;
+			tmp = tmp->next;
+		}
+
+		/* the list changed under the walk, start over */
+		if (unlikely(i != n)) {
+			rte_pause();
+			rte_stack_lf_read_head(list, &old_head);
+			continue;
+		}
+
+		new_head.top = tmp;
+		new_head.cnt = old_head.cnt + 1;
+		if (rte_atomic128_cmp_exchange(&list->head, &old_head,
+				&new_head))
+			return old_head.top;
+	}
+}
+
+static unsigned int
+__rte_stack_lf_push(struct rte_stack *s, void * const *obj_table,
+		unsigned int n)
+{
+	struct rte_stack_lf_elem *first, *last = NULL, *tmp;
+	unsigned int i;
+
+	first = __rte_stack_lf_pop_elems(&s->free, n, NULL, &last);
+	if (first == NULL)
+		return 0;
+
+	/* the last object of obj_table ends up on top */
+	for (tmp = first, i = 0; i < n; i++, tmp = tmp->next)
+		tmp->data = obj_table[n - i - 1];
+
+	__rte_stack_lf_push_elems(&s->used, first, last, n);
+	return n;
+}
+
+static unsigned int
+__rte_stack_lf_pop(struct rte_stack *s, void **obj_table, unsigned int n)
+{
+	struct rte_stack_lf_elem *first, *last = NULL;
+
+	first = __rte_stack_lf_pop_elems(&s->used, n, obj_table, &last);
+	if (first == NULL)
+		return 0;
+
+	__rte_stack_lf_push_elems(&s->free, first, last, n);
+	return n;
+}
+
+static inline void
+__rte_stack_lock(struct rte_stack *s)
+{
+	while (__atomic_exchange_n(&s->lock, 1, __ATOMIC_ACQUIRE) != 0)
+		while (s->lock != 0)
+			rte_pause();
+}
+
+static inline void
+__rte_stack_unlock(struct rte_stack *s)
+{
+	__atomic_store_n(&s->lock, 0, __ATOMIC_RELEASE);
+}
+
+static unsigned int
+__rte_stack_std_push(struct rte_stack *s, void * const *obj_table,
+		unsigned int n)
+{
+	void **objs = (void **)&s[1];
+
+	__rte_stack_lock(s);
+	if (s->len + n > s->capacity) {
+		__rte_stack_unlock(s);
+		return 0;
+	}
+	memcpy(&objs[s->len], obj_table, n * sizeof(void *));
+	s->len += n;
+	__rte_stack_unlock(s);
+
+	return n;
+}
+
+static unsigned int
+__rte_stack_std_pop(struct rte_stack *s, void **obj_table, unsigned int n)
+{
+	void **objs = (void **)&s[1];
+	unsigned int i;
+
+	__rte_stack_lock(s);
+	if (s->len < n) {
+		__rte_stack_unlock(s);
+		return 0;
+	}
+	for (i = 0; i < n; i++)
+		obj_table[i] = objs[s->len - i - 1];
+	s->len -= n;
+	__rte_stack_unlock(s);
+
+	return n;
+}
+
+unsigned int
+rte_stack_push(struct rte_stack *s, void * const *obj_table, unsigned int n)
+{
+	if (n == 0)
+		return 0;
+	if (s->flags & RTE_STACK_F_LF)
+		return __rte_stack_lf_push(s, obj_table, n);
+	return __rte_stack_std_push(s, obj_table, n);
+}
+
+unsigned int
+rte_stack_pop(struct rte_stack *s, void **obj_table, unsigned int n)
+{
+	if (n == 0)
+		return 0;
+	if (s->flags & RTE_STACK_F_LF)
+		return __rte_stack_lf_pop(s, obj_table, n);
+	return __rte_stack_std_pop(s, obj_table, n);
+}
+
+
+ssize_t
+rte_stack_get_memsize(unsigned int count, unsigned int flags)
+{
+	ssize_t sz;
+
+	if (count == 0 || count > RTE_RING_SZ_MASK) {
+		printf("Requested number of elements is invalid, must be non-zero and not exceed %u\n",
+			RTE_RING_SZ_MASK);
+		return -EINVAL;
+	}
+
+	if (flags & RTE_STACK_F_LF)
+		sz = (ssize_t)count * sizeof(struct rte_stack_lf_elem);
+	else
+		sz = (ssize_t)count * sizeof(void *);
+	sz += sizeof(struct rte_stack);
+	sz = RTE_ALIGN(sz, RTE_CACHE_LINE_SIZE);
+	return sz;
+}
+
+
+struct rte_stack *
+rte_stack_create(unsigned int count, unsigned int flags)
+{
+	struct rte_stack_lf_elem *elems;
+	struct rte_stack *s;
+	void *mem_ptr = NULL;
+	ssize_t stack_size;
+	unsigned int i;
+
+	/* future proof flags, only allow supported values */
+	if (flags & ~RTE_STACK_F_MASK) {
+		printf("Unsupported flags requested %#x\n", flags);
+		return NULL;
+	}
+
+	stack_size = rte_stack_get_memsize(count, flags);
+	if (stack_size < 0)
+		return NULL;
+
+	/* list heads must not share a line, and need 16B for the CAS */
+	if (posix_memalign(&mem_ptr, RTE_CACHE_LINE_SIZE, stack_size) != 0) {
+		printf("Cannot reserve memory\n");
+		return NULL;
+	}
+
+	s = mem_ptr;
+	memset(s, 0, sizeof(*s));
+	s->capacity = count;
+	s->flags = flags;
+
+	if (flags & RTE_STACK_F_LF) {
+		/* every list element starts out on the free list */
+		elems = (struct rte_stack_lf_elem *)&s[1];
+		for (i = 0; i < count; i++) {
+			elems[i].data = NULL;
+			elems[i].next = i + 1 < count ? &elems[i + 1] : NULL;
+		}
+		s->free.head.top = &elems[0];
+		s->free.len = count;
+	}
+
+	return s;
+}
+
+
+/* free the stack */
+void
+rte_stack_free(struct rte_stack *s)
+{
+	free(s);
+}
@@ -0,0 +1,100 @@
+#ifndef STACK_H_
+#define STACK_H_
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "ring.h"
+
+/*
+ * LIFO companion of rte_ring for object recycling: the most recently freed
+ * object, still hot in cache, is the next one handed out.
+ *
+ * The default stack is an array guarded by a spinlock. With RTE_STACK_F_LF
+ * it is a lock-free linked list instead: count list elements sit behind the
+ * header, and every object is carried by one of them, moving between the
+ * free list and the used list. Both list heads are {top, cnt} pairs
+ * replaced with a 128-bit CAS; cnt changes on every update so a head that
+ * was popped and pushed back in between (ABA) fails the CAS. List elements
+ * are never returned to the allocator, so following a stale next pointer
+ * is safe and only costs a retry.
+ */
+
+#define RTE_STACK_F_LF 0x0001 /**< Lock-free stack. */
+
+/* mask of all valid flag values to rte_stack_create() */
+#define RTE_STACK_F_MASK (RTE_STACK_F_LF)
+
+struct rte_stack_lf_elem {
+	void *data;                      /**< object carried */
+	struct rte_stack_lf_elem *next;  /**< next element down the list */
+};
+
+struct rte_stack_lf_head {
+	struct rte_stack_lf_elem *top;   /**< top of the list */
+	uint64_t cnt;                    /**< modification counter, ABA guard */
+} __attribute__((__aligned__(16)));
+
+struct rte_stack_lf_list {
+	struct rte_stack_lf_head head;   /**< updated with a 128-bit CAS */
+	uint64_t len;                    /**< elements, reserved before a pop */
+};
+
+struct rte_stack {
+	uint32_t capacity;       /**< Usable size of stack. */
+	uint32_t flags;          /**< Flags supplied at creation. */
+
+	/** Lock-free stack: objects in use and spare list elements. */
+	struct rte_stack_lf_list used __rte_cache_aligned;
+	struct rte_stack_lf_list free __rte_cache_aligned;
+
+	/** Spinlock stack: lock and number of objects in the array. */
+	volatile uint32_t lock __rte_cache_aligned;
+	uint32_t len;
+
+	char pad __rte_cache_aligned; /**< empty cache line */
+	/* followed by capacity list elements or object pointers */
+};
+
+ssize_t rte_stack_get_memsize(unsigned int count, unsigned int flags);
+struct rte_stack *rte_stack_create(unsigned int count, unsigned int flags);
+void rte_stack_free(struct rte_stack *s);
+
+/*
+ * Push or pop n objects, all or nothing like the ring *_bulk calls: return
+ * n, or 0 if there is not enough room or not enough objects. Pushing
+ * obj_table[0..n-1] and popping n gives them back in reverse order.
+ */
+unsigned int rte_stack_push(struct rte_stack *s, void * const *obj_table,
+		unsigned int n);
+unsigned int rte_stack_pop(struct rte_stack *s, void **obj_table,
+		unsigned int n);
+
+/* Number of objects on the stack, only a snapshot when lock-free. */
+static inline unsigned int
+rte_stack_count(const struct rte_stack *s)
+{
+	if (s->flags & RTE_STACK_F_LF)
+		return (unsigned int)__atomic_load_n(&s->used.len,
+				__ATOMIC_RELAXED);
+	return __atomic_load_n(&s->len, __ATOMIC_RELAXED);
+}
+
+static inline unsigned int
+rte_stack_free_count(const struct rte_stack *s)
+{
+	return s->capacity - rte_stack_count(s);
+}
+
+static inline int
+rte_stack_empty(const struct rte_stack *s)
+{
+	return rte_stack_count(s) == 0;
+}
+
+static inline unsigned int
+rte_stack_get_capacity(const struct rte_stack *s)
+{
+	return s->capacity;
+}
+
+#endif
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "ring.h"
+
+/*
+ * Mixes single and multi producer/consumer calls on one ring. The SP/SC
+ * calls cache the other side's tail, the MP/MC calls in between must not
+ * leave that cache claiming room or entries that do not exist.
+ *
+ *   gcc -I. test_sync_mix.c ring.c -lpthread
+ */
+
+#define RING_SIZE 1024
+#define BURST     32
+
+static uintptr_t enq_seq, deq_seq;
+
+static int
+check_fifo(void **objs, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		if ((uintptr_t)objs[i] != deq_seq) {
+			printf("dequeued %lu, expected %lu\n",
+				(unsigned long)(uintptr_t)objs[i],
+				(unsigned long)deq_seq);
+			return -1;
+		}
+		deq_seq++;
+	}
+	return 0;
+}
+
+static unsigned int
+enqueue(struct rte_ring *r, unsigned int n, int sp)
+{
+	void *objs[RING_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		objs[i] = (void *)(enq_seq + i);
+	n = sp ? rte_ring_sp_enqueue_burst(r, objs, n, NULL) :
+		rte_ring_mp_enqueue_burst(r, objs, n, NULL);
+	enq_seq += n;
+	return n;
+}
+
+static int
+dequeue(struct rte_ring *r, unsigned int n, int sc, unsigned int *got)
+{
+	void *objs[RING_SIZE];
+
+	n = sc ? rte_ring_sc_dequeue_burst(r, objs, n, NULL) :
+		rte_ring_mc_dequeue_burst(r, objs, n, NULL);
+	if (got != NULL)
+		*got = n;
+	return check_fifo(objs, n);
+}
+
+int main(void)
+{
+	struct rte_ring *r;
+	void *objs[BURST] = {0};
+	unsigned int i, n, seed = 1;
+
+	r = rte_ring_create(RING_SIZE, 0);
+	if (r == NULL) {
+		printf("create ring failed\n");
+		return -1;
+	}
+
+	/* Prime the SP/SC caches, then move both heads far past them. */
+	enqueue(r, 1, 1);
+	if (dequeue(r, 1, 1, NULL) < 0)
+		return -1;
+	for (i = 0; i < 10000 / BURST; i++) {
+		enqueue(r, BURST, 0);
+		if (dequeue(r, BURST, 0, NULL) < 0)
+			return -1;
+	}
+
+	/* Full ring: a single producer must not find room. */
+	while (enqueue(r, BURST, 0) != 0)
+		;
+	n = rte_ring_sp_enqueue_bulk(r, objs, 10, NULL);
+	if (n != 0 || rte_ring_count(r) != r->capacity) {
+		printf("sp enqueue on a full ring returned %u\n", n);
+		return -1;
+	}
+
+	/* Empty ring: a single consumer must not find entries. */
+	do {
+		if (dequeue(r, BURST, 0, &n) < 0)
+			return -1;
+	} while (n != 0);
+	n = rte_ring_sc_dequeue_bulk(r, objs, 10, NULL);
+	if (n != 0) {
+		printf("sc dequeue on an empty ring returned %u\n", n);
+		return -1;
+	}
+
+	/* Random mix of both kinds on each side, order must hold. */
+	for (i = 0; i < 200000; i++) {
+		enqueue(r, rand_r(&seed) % RING_SIZE, rand_r(&seed) & 1);
+		if (dequeue(r, rand_r(&seed) % RING_SIZE,
+				rand_r(&seed) & 1, NULL) < 0)
+			return -1;
+		if (rte_ring_count(r) != enq_seq - deq_seq) {
+			printf("count %u, expected %lu\n", rte_ring_count(r),
+				(unsigned long)(enq_seq - deq_seq));
+			return -1;
+		}
+	}
+
+	printf("sync mix test passed\n");
+	rte_ring_free(r);
+	return 0;
+}